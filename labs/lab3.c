@@ -1,122 +1,1091 @@
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
+#include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <limits.h>
 #include <time.h>
+#include <math.h>
+#include <glob.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "weather_csv.h"
 
 // -------------------------------------
 // ---------- DATA STRUCTURES ----------
 // -------------------------------------
 typedef struct {
-    long dt;                        // Unix timestamp
-    char dt_iso[64];               // ISO formatted date and time
-    int timezone;                  // Timezone offset
-    char city_name[100];           // City name
-    double lat;                    // Latitude
-    double lon;                    // Longitude
-    double temp;                   // Temperature
-    int visibility;                // Visibility
-    double dew_point;              // Dew point
-    double feels_like;             // Feels like temperature
-    double temp_min;               // Minimum temperature
-    double temp_max;               // Maximum temperature
-    int pressure;                  // Atmospheric pressure
-    int sea_level;                 // Sea level pressure (could be 0 if not provided)
-    int grnd_level;                // Ground level pressure (could be 0 if not provided)
-    int humidity;                  // Humidity percentage
-    double wind_speed;             // Wind speed
-    int wind_deg;                  // Wind direction (degrees)
-    double wind_gust;              // Wind gust speed
-    double rain_1h;                // Rain in the last 1 hour
-    double rain_3h;                // Rain in the last 3 hours
-    double snow_1h;                // Snow in the last 1 hour
-    double snow_3h;                // Snow in the last 3 hours
-    int clouds_all;                // Cloud cover percentage
-    int weather_id;                // Weather condition ID
-    char weather_main[50];         // Main weather condition
-    char weather_description[100]; // Weather description
-    char weather_icon[10];         // Weather icon code
-} DataEntry;
+    char **strings;  // distinct values, indexed by their id
+    int count;       // number of distinct values
+    int capacity;    // allocated entries in strings
+    int *slots;      // open addressing hash table of ids, -1 for empty slots
+    int slot_count;  // size of the hash table (a power of two)
+    int last;        // id found by the previous lookup, tried first since values come in runs
+} StringDictionary;
+
+typedef struct {
+    int count;                     // number of rows
+    int capacity;                  // rows allocated in every column
+    long *dt;                      // Unix timestamps (dt_iso is rebuilt from them)
+    int *timezone;
+    double *lat;
+    double *lon;
+    double *temp;
+    int *visibility;
+    double *dew_point;
+    double *feels_like;
+    double *temp_min;
+    double *temp_max;
+    int *pressure;
+    int *sea_level;
+    int *grnd_level;
+    int *humidity;
+    double *wind_speed;
+    int *wind_deg;
+    double *wind_gust;
+    double *rain_1h;
+    double *rain_3h;
+    double *snow_1h;
+    double *snow_3h;
+    int *clouds_all;
+    int *weather_id;
+    int *city;                     // ids into cities
+    int *weather_main;             // ids into mains
+    int *weather_description;      // ids into descriptions
+    int *weather_icon;             // ids into icons
+    unsigned int *nulls;           // empty fields of every row, one bit per WeatherField
+    int null_counts[WEATHER_FIELD_COUNT]; // rows where each field is empty; 0 lets the kernels skip the checks
+    int *by_dt;                    // rows sorted by dt, built by buildDateIndex
+    int indexed;                   // rows covered by by_dt, it is rebuilt once rows are appended
+    StringDictionary cities;
+    StringDictionary mains;
+    StringDictionary descriptions;
+    StringDictionary icons;
+} WeatherTable;
+
+typedef struct {
+    StringDictionary keys;  // label of every group; the id of a label is the number of its group
+    long long *counts;      // rows of every group
+    long long *samples;     // rows of every group that had the aggregated value (not null), the divisor of its mean
+    double *sums;           // sum of the aggregated value of every group
+    int capacity;           // allocated entries in counts, samples and sums
+} GroupBy;
+
+typedef enum {
+    GROUP_WEATHER_MAIN,
+    GROUP_WEATHER_DESCRIPTION,
+    GROUP_WEATHER_ID
+} GroupColumn;
 
 typedef struct {
     double avg_temp;
     double avg_humidity;
     double avg_pressure;
-    struct {
-        char type[50];
-        int count;
-    } weather_types[10];
-    int weather_type_count;
+    GroupBy weather_types;  // rows of every weather_main, released with freeBasicStatistics
 } BasicStatistics;
 
 typedef struct {
-    DataEntry *entries;
+    int *rows;  // indices of the matching rows in the table
     int count;
 } FilteredResults;
 
 typedef struct {
-    DataEntry highest_temp;
-    DataEntry lowest_temp;
-    DataEntry strongest_wind;
-    DataEntry highest_humidity;
+    const int *rows;  // rows in dt order, a window into the table's date index (nothing to free)
+    int count;
+} RowSpan;
+
+typedef struct {
+    double value;
+    int row;    // row in the table, or observation number for an aggregator; -1 if no row had a value
+    long dt;    // when it was observed
+} ExtremeValue;
+
+typedef struct {
+    ExtremeValue highest_temp;
+    ExtremeValue lowest_temp;
+    ExtremeValue strongest_wind;
+    ExtremeValue highest_humidity;
 } ExtremeValues;
 
+typedef enum {
+    EXTREME_HIGHEST_TEMP,
+    EXTREME_LOWEST_TEMP,
+    EXTREME_STRONGEST_WIND,
+    EXTREME_HIGHEST_HUMIDITY,
+    EXTREME_KIND_COUNT
+} ExtremeKind;
+
+typedef struct {
+    double key;  // value the rows are ranked by, higher is better (the lowest temperature is stored negated)
+    int row;
+} RankedRow;
+
+typedef struct {
+    RankedRow *rows;  // a heap with the worst kept row on top while scanning, best first afterwards
+    int count;
+    int k;            // number of rows to keep
+} TopK;
+
+typedef struct {
+    double total_temp;    // sums over the rows where the field is not null
+    long long total_humidity;
+    long long total_pressure;
+    long long temp_rows;  // rows that had each field
+    long long humidity_rows;
+    long long pressure_rows;
+    int highest_temp;     // row indices of the extremes, the earliest row on ties, -1 if every row is null
+    int lowest_temp;
+    int strongest_wind;
+    int highest_humidity;
+} WeatherReduction;
+
+typedef struct {
+    long long rows;
+    double total_temp;             // sums over the rows where the field is not null
+    long long total_humidity;
+    long long total_pressure;
+    long long temp_rows;           // rows that had each field, the divisors of the averages
+    long long humidity_rows;
+    long long pressure_rows;
+    GroupBy weather_types;         // rows of every weather_main, merged by name across files
+    double hour_temp[24];          // temperature sum of every UTC hour
+    long long hour_count[24];      // rows of every UTC hour with a temperature
+} WeatherPartial;
+
 typedef struct {
     int hour;
     double avg_temp;
     double temp_trend;
 } HourlyAnalysis;
 
-// ----------------------------
-// ----- BASIC STATISTICS -----
-// ----------------------------
-BasicStatistics calculateBasicStatistics(DataEntry *entries, int numEntries) {
+typedef struct {
+    int year;
+    int month;        // 1-12
+    int day_of_year;  // 1-366
+    int hour;         // 0-23
+} CalendarFields;
+
+typedef enum {
+    BUCKET_HOUR_OF_DAY,
+    BUCKET_DAY_OF_YEAR,
+    BUCKET_MONTH,
+    BUCKET_YEAR
+} BucketGranularity;
+
+typedef struct {
+    int key;            // hour of day, day of year, month or year, depending on the granularity
+    long long count;
+    double mean;        // holds the sum of the temperatures until the pass is over
+    double min;
+    double max;
+    double trend;       // linear change of the temperature inside the bucket, in °C per year
+    double sum_x;       // sums behind the trend, x being days since the first row
+    double sum_x2;
+    double sum_xy;
+} CalendarBucket;
+
+#define ROLLING_MAX_WIDTHS 8
+
+typedef enum {
+    ROLLING_TEMP,
+    ROLLING_HUMIDITY,
+    ROLLING_WIND,
+    ROLLING_FIELD_COUNT
+} RollingField;
+
+typedef struct {
+    float mean;
+    float min;
+    float max;
+} RollingPoint;
+
+typedef struct {
+    int width_count;
+    long widths[ROLLING_MAX_WIDTHS];  // window widths in seconds, a window holds the rows with dt in (t - width, t]
+    int count;                        // points in the series
+    long *dt;                         // time of every point
+    RollingPoint *points;             // for point i, width w and field f: points[(i * width_count + w) * ROLLING_FIELD_COUNT + f]
+} RollingSeries;
+
+typedef enum {
+    CHART_BARS,                    // UTF-8 bars for the terminal
+    CHART_CSV,                     // chart,label,value,bar rows for dashboards, under one header per run
+    CHART_JSON                     // one object per chart for dashboards
+} ChartFormat;
+
+typedef struct {
+    char *data;                    // the whole chart, written out with a single fwrite
+    size_t length;
+    size_t capacity;
+} ChartBuffer;
+
+typedef struct {
+    long long rows;
+    long last_dt;                  // newest dt aggregated so far
+    long offset;                   // bytes of the feed already aggregated
+    unsigned long long feed_device;// device and inode of the feed, a different file means it was rotated
+    unsigned long long feed_inode;
+    long feed_prefix;              // bytes at the start of the feed covered by feed_hash
+    unsigned int feed_hash;        // hash of those bytes, catches a feed truncated and rewritten in place
+    long long temp_rows;           // observations that had each field, nulls are skipped per field
+    long long humidity_rows;
+    long long pressure_rows;
+    long long wind_rows;
+    double temp_mean;              // Welford running means and sums of squared differences from them
+    double temp_m2;
+    double humidity_mean;
+    double humidity_m2;
+    double pressure_mean;
+    double pressure_m2;
+    ExtremeValues extremes;
+    double hour_temp[24];          // temperature sum of every UTC hour
+    long long hour_count[24];
+} AggregatorState;                 // only plain numbers, so checkpoints store it as is
+
+typedef struct {
+    AggregatorState state;
+    GroupBy weather_types;         // rows of every weather_main
+} WeatherAggregator;
+
+typedef struct {
+    BasicStatistics stats;
+    double temp_stddev;
+    double humidity_stddev;
+    double pressure_stddev;
+    ExtremeValues extremes;
+    HourlyAnalysis *hourly;        // see calculateHourlyTemperatures
+    int num_hours;
+} WeatherSnapshot;
+
+// -----------------------------
+// ----- STRING DICTIONARY -----
+// -----------------------------
+unsigned int hashString(const char *str, size_t length) {
+    /*
+     * function for hashing a string (FNV-1a)
+     * */
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char) str[i]) * 16777619u;
+    }
+    return hash;
+}
+
+int sameString(const char *stored, const char *str, size_t length) {
+    /*
+     * function for comparing a stored string with a piece of text that is not NUL-terminated
+     * */
+    return strncmp(stored, str, length) == 0 && stored[length] == '\0';
+}
+
+int internString(StringDictionary *dict, const char *str, size_t length) {
+    /*
+     * Function for finding the id of a string, adding it to the dictionary if it is new
+     *  @param dict: pointer to the dictionary
+     *  @param str: string to look up (it does not need to be NUL-terminated)
+     *  @param length: length of str
+     * @return: id of the string, -1 if out of memory
+     * */
+    if (dict->last < dict->count && sameString(dict->strings[dict->last], str, length)) {
+        return dict->last;
+    }
+
+    // --- keeping the hash table at most half full ---
+    if (2 * (dict->count + 1) > dict->slot_count) {
+        int slot_count = dict->slot_count ? dict->slot_count * 2 : 64;
+        int *slots = malloc(slot_count * sizeof(int));
+        if (!slots) {
+            return -1;
+        }
+        memset(slots, -1, slot_count * sizeof(int));
+        for (int id = 0; id < dict->count; id++) {
+            unsigned int slot = hashString(dict->strings[id], strlen(dict->strings[id])) & (slot_count - 1);
+            while (slots[slot] >= 0) {
+                slot = (slot + 1) & (slot_count - 1);
+            }
+            slots[slot] = id;
+        }
+        free(dict->slots);
+        dict->slots = slots;
+        dict->slot_count = slot_count;
+    }
+
+    // --- probing until we find the string or an empty slot ---
+    unsigned int slot = hashString(str, length) & (dict->slot_count - 1);
+    while (dict->slots[slot] >= 0) {
+        if (sameString(dict->strings[dict->slots[slot]], str, length)) {
+            dict->last = dict->slots[slot];
+            return dict->last;
+        }
+        slot = (slot + 1) & (dict->slot_count - 1);
+    }
+
+    if (dict->count == dict->capacity) {
+        int capacity = dict->capacity ? dict->capacity * 2 : 16;
+        char **strings = realloc(dict->strings, capacity * sizeof(char *));
+        if (!strings) {
+            return -1;
+        }
+        dict->strings = strings;
+        dict->capacity = capacity;
+    }
+    char *copy = malloc(length + 1);
+    if (!copy) {
+        return -1;
+    }
+    memcpy(copy, str, length);
+    copy[length] = '\0';
+    dict->strings[dict->count] = copy;
+    dict->slots[slot] = dict->count;
+    dict->last = dict->count;
+    return dict->count++;
+}
+
+void freeStringDictionary(StringDictionary *dict) {
+    /*
+     * function for releasing a dictionary
+     * */
+    for (int i = 0; i < dict->count; i++) {
+        free(dict->strings[i]);
+    }
+    free(dict->strings);
+    free(dict->slots);
+    memset(dict, 0, sizeof(StringDictionary));
+}
+
+// -------------------------
+// ----- WEATHER TABLE -----
+// -------------------------
+int reserveWeatherTable(WeatherTable *table, int capacity) {
+    /*
+     * Function for growing every column of the table to at least a number of rows
+     *  @param table: pointer to the table
+     *  @param capacity: number of rows needed
+     * @return: 1 if successful, 0 if out of memory
+     * */
+    if (capacity <= table->capacity) {
+        return 1;
+    }
+
+    // --- every column, with the size of one of its values ---
+    struct {
+        void **data;
+        size_t size;
+    } columns[] = {
+            {(void **) &table->dt, sizeof(long)},
+            {(void **) &table->timezone, sizeof(int)},
+            {(void **) &table->lat, sizeof(double)},
+            {(void **) &table->lon, sizeof(double)},
+            {(void **) &table->temp, sizeof(double)},
+            {(void **) &table->visibility, sizeof(int)},
+            {(void **) &table->dew_point, sizeof(double)},
+            {(void **) &table->feels_like, sizeof(double)},
+            {(void **) &table->temp_min, sizeof(double)},
+            {(void **) &table->temp_max, sizeof(double)},
+            {(void **) &table->pressure, sizeof(int)},
+            {(void **) &table->sea_level, sizeof(int)},
+            {(void **) &table->grnd_level, sizeof(int)},
+            {(void **) &table->humidity, sizeof(int)},
+            {(void **) &table->wind_speed, sizeof(double)},
+            {(void **) &table->wind_deg, sizeof(int)},
+            {(void **) &table->wind_gust, sizeof(double)},
+            {(void **) &table->rain_1h, sizeof(double)},
+            {(void **) &table->rain_3h, sizeof(double)},
+            {(void **) &table->snow_1h, sizeof(double)},
+            {(void **) &table->snow_3h, sizeof(double)},
+            {(void **) &table->clouds_all, sizeof(int)},
+            {(void **) &table->weather_id, sizeof(int)},
+            {(void **) &table->city, sizeof(int)},
+            {(void **) &table->weather_main, sizeof(int)},
+            {(void **) &table->weather_description, sizeof(int)},
+            {(void **) &table->weather_icon, sizeof(int)},
+            {(void **) &table->nulls, sizeof(unsigned int)},
+    };
+
+    for (size_t i = 0; i < sizeof(columns) / sizeof(columns[0]); i++) {
+        void *data = realloc(*columns[i].data, capacity * columns[i].size);
+        if (!data) {
+            return 0;
+        }
+        *columns[i].data = data;
+    }
+    table->capacity = capacity;
+    return 1;
+}
+
+int appendCsvLine(WeatherTable *table, const char *line) {
+    /*
+     * Function for parsing one CSV line straight into the columns of the table
+     *  @param table: pointer to the table
+     *  @param line: the line, with or without its line break
+     * @return: 1 if successful, 0 if out of memory
+     * */
+    if (table->count == table->capacity &&
+        !reserveWeatherTable(table, table->capacity ? table->capacity * 2 : 1024)) {
+        return 0;
+    }
+
+    int i = table->count;
+    const char *p = line, *text;
+    size_t length;
+    unsigned int nulls = 0;
+
+    // --- every field is parsed where it lies in the line; text fields are only hashed, never copied ---
+    nulls |= (unsigned) !csvNextLong(&p, &table->dt[i]) << WEATHER_DT;
+    nulls |= (unsigned) !csvNextSlice(&p, &text, &length) << WEATHER_DT_ISO; // rebuilt from dt when needed
+    nulls |= (unsigned) !csvNextInt(&p, &table->timezone[i]) << WEATHER_TIMEZONE;
+    nulls |= (unsigned) !csvNextSlice(&p, &text, &length) << WEATHER_CITY_NAME;
+    table->city[i] = internString(&table->cities, text, length);
+    nulls |= (unsigned) !csvNextDouble(&p, &table->lat[i]) << WEATHER_LAT;
+    nulls |= (unsigned) !csvNextDouble(&p, &table->lon[i]) << WEATHER_LON;
+    nulls |= (unsigned) !csvNextDouble(&p, &table->temp[i]) << WEATHER_TEMP;
+    nulls |= (unsigned) !csvNextInt(&p, &table->visibility[i]) << WEATHER_VISIBILITY;
+    nulls |= (unsigned) !csvNextDouble(&p, &table->dew_point[i]) << WEATHER_DEW_POINT;
+    nulls |= (unsigned) !csvNextDouble(&p, &table->feels_like[i]) << WEATHER_FEELS_LIKE;
+    nulls |= (unsigned) !csvNextDouble(&p, &table->temp_min[i]) << WEATHER_TEMP_MIN;
+    nulls |= (unsigned) !csvNextDouble(&p, &table->temp_max[i]) << WEATHER_TEMP_MAX;
+    nulls |= (unsigned) !csvNextInt(&p, &table->pressure[i]) << WEATHER_PRESSURE;
+    nulls |= (unsigned) !csvNextInt(&p, &table->sea_level[i]) << WEATHER_SEA_LEVEL;
+    nulls |= (unsigned) !csvNextInt(&p, &table->grnd_level[i]) << WEATHER_GRND_LEVEL;
+    nulls |= (unsigned) !csvNextInt(&p, &table->humidity[i]) << WEATHER_HUMIDITY;
+    nulls |= (unsigned) !csvNextDouble(&p, &table->wind_speed[i]) << WEATHER_WIND_SPEED;
+    nulls |= (unsigned) !csvNextInt(&p, &table->wind_deg[i]) << WEATHER_WIND_DEG;
+    nulls |= (unsigned) !csvNextDouble(&p, &table->wind_gust[i]) << WEATHER_WIND_GUST;
+    nulls |= (unsigned) !csvNextDouble(&p, &table->rain_1h[i]) << WEATHER_RAIN_1H;
+    nulls |= (unsigned) !csvNextDouble(&p, &table->rain_3h[i]) << WEATHER_RAIN_3H;
+    nulls |= (unsigned) !csvNextDouble(&p, &table->snow_1h[i]) << WEATHER_SNOW_1H;
+    nulls |= (unsigned) !csvNextDouble(&p, &table->snow_3h[i]) << WEATHER_SNOW_3H;
+    nulls |= (unsigned) !csvNextInt(&p, &table->clouds_all[i]) << WEATHER_CLOUDS_ALL;
+    nulls |= (unsigned) !csvNextInt(&p, &table->weather_id[i]) << WEATHER_WEATHER_ID;
+    nulls |= (unsigned) !csvNextSlice(&p, &text, &length) << WEATHER_WEATHER_MAIN;
+    table->weather_main[i] = internString(&table->mains, text, length);
+    nulls |= (unsigned) !csvNextSlice(&p, &text, &length) << WEATHER_WEATHER_DESCRIPTION;
+    table->weather_description[i] = internString(&table->descriptions, text, length);
+    nulls |= (unsigned) !csvNextSlice(&p, &text, &length) << WEATHER_WEATHER_ICON;
+    table->weather_icon[i] = internString(&table->icons, text, length);
+    table->nulls[i] = nulls;
+
+    if (table->city[i] < 0 || table->weather_main[i] < 0 || table->weather_description[i] < 0 ||
+        table->weather_icon[i] < 0) {
+        return 0;
+    }
+
+    for (unsigned int bits = nulls; bits; bits &= bits - 1) {
+        table->null_counts[__builtin_ctz(bits)]++;
+    }
+    table->count++;
+    return 1;
+}
+
+int isNull(const WeatherTable *table, int row, WeatherField field) {
+    /*
+     * function for checking if a field of a row was empty in the CSV, so it must not count as a 0
+     * */
+    return (int) (table->nulls[row] >> field & 1);
+}
+
+void formatTimestamp(long timestamp, char *text, size_t size) {
     /*
-     * function for computing the basic statistics
+     * function for writing a Unix time the way the dataset's dt_iso does, which is the UTC time of dt
      * */
-    BasicStatistics stats = {0};
-    double total_temp = 0, total_humidity = 0, total_pressure = 0;
+    time_t dt = (time_t) timestamp;
+    struct tm tm;
+    gmtime_r(&dt, &tm);
+    strftime(text, size, "%Y-%m-%d %H:%M:%S +0000 UTC", &tm);
+}
 
-    // Initialize weather type counts
-    stats.weather_type_count = 0;
+void getDataEntry(const WeatherTable *table, int row, DataEntry *entry) {
+    /*
+     * Function for gathering one row of the table back into a record
+     *  @param table: pointer to the table
+     *  @param row: index of the row
+     *  @param entry: where to store the record
+     * */
+    entry->dt = table->dt[row];
+    entry->timezone = table->timezone[row];
+    entry->lat = table->lat[row];
+    entry->lon = table->lon[row];
+    entry->temp = table->temp[row];
+    entry->visibility = table->visibility[row];
+    entry->dew_point = table->dew_point[row];
+    entry->feels_like = table->feels_like[row];
+    entry->temp_min = table->temp_min[row];
+    entry->temp_max = table->temp_max[row];
+    entry->pressure = table->pressure[row];
+    entry->sea_level = table->sea_level[row];
+    entry->grnd_level = table->grnd_level[row];
+    entry->humidity = table->humidity[row];
+    entry->wind_speed = table->wind_speed[row];
+    entry->wind_deg = table->wind_deg[row];
+    entry->wind_gust = table->wind_gust[row];
+    entry->rain_1h = table->rain_1h[row];
+    entry->rain_3h = table->rain_3h[row];
+    entry->snow_1h = table->snow_1h[row];
+    entry->snow_3h = table->snow_3h[row];
+    entry->clouds_all = table->clouds_all[row];
+    entry->weather_id = table->weather_id[row];
+
+    formatTimestamp(table->dt[row], entry->dt_iso, sizeof(entry->dt_iso));
+
+    snprintf(entry->city_name, sizeof(entry->city_name), "%s", table->cities.strings[table->city[row]]);
+    snprintf(entry->weather_main, sizeof(entry->weather_main), "%s", table->mains.strings[table->weather_main[row]]);
+    snprintf(entry->weather_description, sizeof(entry->weather_description), "%s",
+             table->descriptions.strings[table->weather_description[row]]);
+    snprintf(entry->weather_icon, sizeof(entry->weather_icon), "%s", table->icons.strings[table->weather_icon[row]]);
+}
+
+void freeWeatherTable(WeatherTable *table) {
+    /*
+     * function for releasing every column and dictionary of the table
+     * */
+    void *columns[] = {
+            table->dt, table->timezone, table->lat, table->lon, table->temp, table->visibility, table->dew_point,
+            table->feels_like, table->temp_min, table->temp_max, table->pressure, table->sea_level,
+            table->grnd_level, table->humidity, table->wind_speed, table->wind_deg, table->wind_gust,
+            table->rain_1h, table->rain_3h, table->snow_1h, table->snow_3h, table->clouds_all, table->weather_id,
+            table->city, table->weather_main, table->weather_description, table->weather_icon, table->nulls,
+            table->by_dt
+    };
+    for (size_t i = 0; i < sizeof(columns) / sizeof(columns[0]); i++) {
+        free(columns[i]);
+    }
+    freeStringDictionary(&table->cities);
+    freeStringDictionary(&table->mains);
+    freeStringDictionary(&table->descriptions);
+    freeStringDictionary(&table->icons);
+    free(table);
+}
+
+// --------------------
+// ----- GROUP BY -----
+// --------------------
+int groupByAdd(GroupBy *groups, const char *key, size_t length, long long count, long long samples, double sum) {
+    /*
+     * Function for adding rows to a group, creating the group if its key is new
+     *  @param groups: pointer to the group-by
+     *  @param key: label of the group (it does not need to be NUL-terminated)
+     *  @param length: length of key
+     *  @param count: number of rows to add
+     *  @param samples: how many of them had the aggregated value (the others were null)
+     *  @param sum: sum of their aggregated values
+     * @return: number of the group, -1 if out of memory
+     * */
+    // --- room for one more group comes first, so a failed allocation never leaves a key without its count ---
+    if (groups->keys.count >= groups->capacity) {
+        int capacity = groups->capacity ? groups->capacity * 2 : 16;
+        long long *counts = realloc(groups->counts, capacity * sizeof(long long));
+        if (counts) {
+            groups->counts = counts;
+        }
+        long long *samples_grown = realloc(groups->samples, capacity * sizeof(long long));
+        if (samples_grown) {
+            groups->samples = samples_grown;
+        }
+        double *sums = realloc(groups->sums, capacity * sizeof(double));
+        if (sums) {
+            groups->sums = sums;
+        }
+        if (!counts || !samples_grown || !sums) {
+            return -1;
+        }
+        memset(counts + groups->capacity, 0, (capacity - groups->capacity) * sizeof(long long));
+        memset(samples_grown + groups->capacity, 0, (capacity - groups->capacity) * sizeof(long long));
+        memset(sums + groups->capacity, 0, (capacity - groups->capacity) * sizeof(double));
+        groups->capacity = capacity;
+    }
+
+    int group = internString(&groups->keys, key, length);
+    if (group < 0) {
+        return -1;
+    }
+    groups->counts[group] += count;
+    groups->samples[group] += samples;
+    groups->sums[group] += sum;
+    return group;
+}
+
+int mergeGroupBy(GroupBy *into, const GroupBy *from) {
+    /*
+     * Function for adding every group of one group-by to another, matching them by key
+     *  @param into: pointer to the group-by that receives the groups
+     *  @param from: pointer to the group-by to add
+     * @return: 1 if successful, 0 if out of memory
+     * */
+    for (int group = 0; group < from->keys.count; group++) {
+        const char *key = from->keys.strings[group];
+        if (groupByAdd(into, key, strlen(key), from->counts[group], from->samples[group], from->sums[group]) < 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
 
-    // Temporary arrays to track weather type counts
-    char weather_types[10][50] = {0};
-    int weather_counts[10] = {0};
+double groupMean(const GroupBy *groups, int group) {
+    /*
+     * function for the mean of the aggregated value of a group, NAN if every row of it was null
+     * */
+    return groups->samples[group] ? groups->sums[group] / groups->samples[group] : NAN;
+}
 
-    for (int i = 0; i < numEntries; i++) {
-        // Accumulate totals
-        total_temp += entries[i].temp;
-        total_humidity += entries[i].humidity;
-        total_pressure += entries[i].pressure;
+void freeGroupBy(GroupBy *groups) {
+    /*
+     * function for releasing a group-by
+     * */
+    freeStringDictionary(&groups->keys);
+    free(groups->counts);
+    free(groups->samples);
+    free(groups->sums);
+    memset(groups, 0, sizeof(GroupBy));
+}
 
-        int found = 0;
-        for (int j = 0; j < stats.weather_type_count; j++) {
-            if (strcmp(weather_types[j], entries[i].weather_main) == 0) {
-                weather_counts[j]++;
-                found = 1;
-                break;
+int groupWeatherTable(GroupBy *groups, const WeatherTable *table, GroupColumn column, const double *values,
+                      WeatherField value_field) {
+    /*
+     * Function for counting the rows of a table per value of a column, and summing another column per group
+     *  @param groups: pointer to the group-by that receives the groups (it may already hold some)
+     *  @param table: pointer to the table
+     *  @param column: column to group by
+     *  @param values: column to sum and average per group (one entry per row), NULL to only count
+     *  @param value_field: the field of values, whose nulls are left out of the sums and means
+     * @return: 1 if successful, 0 if out of memory
+     * */
+    unsigned int null_bit = values && table->null_counts[value_field] ? 1u << value_field : 0;
+
+    if (column == GROUP_WEATHER_ID) {
+        // --- ids come in runs, so a run is summed here and the key is formatted and hashed once per run ---
+        char key[16];
+        for (int i = 0; i < table->count;) {
+            int run = i;
+            long long samples = 0;
+            double sum = 0;
+            for (; run < table->count && table->weather_id[run] == table->weather_id[i]; run++) {
+                if (values && !(table->nulls[run] & null_bit)) {
+                    sum += values[run];
+                    samples++;
+                }
+            }
+            int length = snprintf(key, sizeof(key), "%d", table->weather_id[i]);
+            if (groupByAdd(groups, key, (size_t) length, run - i, samples, sum) < 0) {
+                return 0;
             }
+            i = run;
         }
+        return 1;
+    }
 
-        // If not found, add new weather type
-        if (!found) {
-            strcpy(weather_types[stats.weather_type_count], entries[i].weather_main);
-            weather_counts[stats.weather_type_count] = 1;
-            stats.weather_type_count++;
+    // --- string columns are already dictionary encoded: rows are counted by id, then the few ids by name ---
+    const int *ids = column == GROUP_WEATHER_MAIN ? table->weather_main : table->weather_description;
+    const StringDictionary *dict = column == GROUP_WEATHER_MAIN ? &table->mains : &table->descriptions;
+
+    // --- runs of the same id would make every increment wait for the last one, so 4 count arrays take turns ---
+    int types = dict->count ? dict->count : 1;
+    int *counts = calloc(4 * types, sizeof(int));
+    int *samples = calloc(types, sizeof(int));
+    double *sums = calloc(types, sizeof(double));
+    int ok = counts && samples && sums;
+    for (int i = 0; ok && i < table->count; i++) {
+        counts[(i & 3) * types + ids[i]]++;
+    }
+    if (ok && values && !null_bit) {
+        for (int i = 0; i < table->count; i++) {
+            sums[ids[i]] += values[i];
+        }
+    } else if (ok && values) {
+        for (int i = 0; i < table->count; i++) {
+            if (!(table->nulls[i] & null_bit)) {
+                sums[ids[i]] += values[i];
+                samples[ids[i]]++;
+            }
         }
     }
 
-    // --- computing averages ---
-    stats.avg_temp = total_temp / numEntries;
-    stats.avg_humidity = total_humidity / numEntries;
-    stats.avg_pressure = total_pressure / numEntries;
+    // --- ids follow the order of first appearance, and so do the new groups ---
+    for (int id = 0; ok && id < dict->count; id++) {
+        long long count = counts[id] + counts[types + id] + counts[2 * types + id] + counts[3 * types + id];
+        long long valued = !values ? 0 : null_bit ? samples[id] : count;
+        ok = groupByAdd(groups, dict->strings[id], strlen(dict->strings[id]), count, valued, sums[id]) >= 0;
+    }
+    free(counts);
+    free(samples);
+    free(sums);
+    return ok;
+}
 
-    for (int i = 0; i < stats.weather_type_count; i++) {
-        strcpy(stats.weather_types[i].type, weather_types[i]);
-        stats.weather_types[i].count = weather_counts[i];
+void printGroupBy(const GroupBy *groups, const char *value_name) {
+    /*
+     * Function for printing every group with its row count and mean
+     *  @param groups: pointer to the group-by
+     *  @param value_name: name of the averaged value, NULL to print only the counts
+     * */
+    for (int group = 0; group < groups->keys.count; group++) {
+        printf("%s: %lld", groups->keys.strings[group], groups->counts[group]);
+        if (value_name && groups->samples[group] == 0) {
+            printf(" rows, Avg %s = n/a", value_name);
+        } else if (value_name) {
+            printf(" rows, Avg %s = %.2f", value_name, groupMean(groups, group));
+        }
+        printf("\n");
     }
+}
 
-    return stats;
+// ---------------------------------
+// ----- VECTORIZED REDUCTIONS -----
+// ---------------------------------
+void reduceWeatherRows(const WeatherTable *table, int start, WeatherReduction *result) {
+    /*
+     * Function for adding the rows from start to the end of the table into a reduction (the scalar kernel);
+     * null fields are left out of the sums and the extremes
+     *  @param table: pointer to the table
+     *  @param start: first row to add
+     *  @param result: reduction of the rows before start (zero sums and -1 extremes when start is 0)
+     * */
+    for (int i = start; i < table->count; i++) {
+        unsigned int nulls = table->nulls[i];
+
+        // --- strict compares keep the earliest row on ties ---
+        if (!(nulls >> WEATHER_TEMP & 1)) {
+            double temp = table->temp[i];
+            result->total_temp += temp;
+            result->temp_rows++;
+            if (result->highest_temp < 0 || temp > table->temp[result->highest_temp]) {
+                result->highest_temp = i;
+            }
+            if (result->lowest_temp < 0 || temp < table->temp[result->lowest_temp]) {
+                result->lowest_temp = i;
+            }
+        }
+        if (!(nulls >> WEATHER_HUMIDITY & 1)) {
+            result->total_humidity += table->humidity[i];
+            result->humidity_rows++;
+            if (result->highest_humidity < 0 || table->humidity[i] > table->humidity[result->highest_humidity]) {
+                result->highest_humidity = i;
+            }
+        }
+        if (!(nulls >> WEATHER_PRESSURE & 1)) {
+            result->total_pressure += table->pressure[i];
+            result->pressure_rows++;
+        }
+        if (!(nulls >> WEATHER_WIND_SPEED & 1) &&
+            (result->strongest_wind < 0 || table->wind_speed[i] > table->wind_speed[result->strongest_wind])) {
+            result->strongest_wind = i;
+        }
+    }
+}
+
+void reduceWeatherScalar(const WeatherTable *table, WeatherReduction *result) {
+    /*
+     * function for reducing the whole table without vector instructions
+     * */
+    reduceWeatherRows(table, 0, result);
+}
+
+int foldLanes(const double *values, const double *rows, int lanes, int lowest) {
+    /*
+     * Function for picking the winner among the per-lane extremes of a vector kernel
+     *  @param values: best value of every lane
+     *  @param rows: row of that value in every lane
+     *  @param lanes: number of lanes
+     *  @param lowest: 1 to look for the minimum, 0 for the maximum
+     * @return: row of the extreme, the earliest one on ties
+     * */
+    int best = 0;
+    for (int lane = 1; lane < lanes; lane++) {
+        int better = lowest ? values[lane] < values[best] : values[lane] > values[best];
+        if (better || (values[lane] == values[best] && rows[lane] < rows[best])) {
+            best = lane;
+        }
+    }
+    return (int) rows[best];
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+void reduceWeatherAvx2(const WeatherTable *table, WeatherReduction *result) {
+    /*
+     * Function for reducing the table 4 rows at a time with AVX2
+     *  @param table: pointer to a table with at least one row and no nulls in the reduced columns
+     *  @param result: where to store the reduction (every field is overwritten)
+     * */
+    int vectorized = table->count & ~3;
+
+    // --- every lane keeps its own sums and extremes; row numbers and the integer columns ride along as doubles,
+    //     which holds them exactly ---
+    __m256d sum_temp = _mm256_setzero_pd(), sum_humidity = _mm256_setzero_pd(), sum_pressure = _mm256_setzero_pd();
+    __m256d high_temp = _mm256_set1_pd(table->temp[0]), low_temp = high_temp;
+    __m256d high_wind = _mm256_set1_pd(table->wind_speed[0]);
+    __m256d high_humidity = _mm256_set1_pd(table->humidity[0]);
+    __m256d high_temp_row = _mm256_setzero_pd(), low_temp_row = _mm256_setzero_pd();
+    __m256d high_wind_row = _mm256_setzero_pd(), high_humidity_row = _mm256_setzero_pd();
+    __m256d row = _mm256_set_pd(3, 2, 1, 0), step = _mm256_set1_pd(4);
+
+    for (int i = 0; i < vectorized; i += 4) {
+        __m256d temp = _mm256_loadu_pd(table->temp + i);
+        __m256d wind = _mm256_loadu_pd(table->wind_speed + i);
+        __m256d humidity = _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i *) (table->humidity + i)));
+        __m256d pressure = _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i *) (table->pressure + i)));
+
+        sum_temp = _mm256_add_pd(sum_temp, temp);
+        sum_humidity = _mm256_add_pd(sum_humidity, humidity);
+        sum_pressure = _mm256_add_pd(sum_pressure, pressure);
+
+        // --- max/min carry the values, the strict compare decides if the row moves ---
+        __m256d mask = _mm256_cmp_pd(temp, high_temp, _CMP_GT_OQ);
+        high_temp = _mm256_max_pd(high_temp, temp);
+        high_temp_row = _mm256_blendv_pd(high_temp_row, row, mask);
+
+        mask = _mm256_cmp_pd(temp, low_temp, _CMP_LT_OQ);
+        low_temp = _mm256_min_pd(low_temp, temp);
+        low_temp_row = _mm256_blendv_pd(low_temp_row, row, mask);
+
+        mask = _mm256_cmp_pd(wind, high_wind, _CMP_GT_OQ);
+        high_wind = _mm256_max_pd(high_wind, wind);
+        high_wind_row = _mm256_blendv_pd(high_wind_row, row, mask);
+
+        mask = _mm256_cmp_pd(humidity, high_humidity, _CMP_GT_OQ);
+        high_humidity = _mm256_max_pd(high_humidity, humidity);
+        high_humidity_row = _mm256_blendv_pd(high_humidity_row, row, mask);
+
+        row = _mm256_add_pd(row, step);
+    }
+
+    // --- folding the lanes ---
+    double lanes[4][4], rows[4];
+    _mm256_storeu_pd(lanes[0], sum_temp);
+    _mm256_storeu_pd(lanes[1], sum_humidity);
+    _mm256_storeu_pd(lanes[2], sum_pressure);
+    result->total_temp = lanes[0][0] + lanes[0][1] + lanes[0][2] + lanes[0][3];
+    result->total_humidity = (long long) (lanes[1][0] + lanes[1][1] + lanes[1][2] + lanes[1][3]);
+    result->total_pressure = (long long) (lanes[2][0] + lanes[2][1] + lanes[2][2] + lanes[2][3]);
+
+    _mm256_storeu_pd(lanes[0], high_temp);
+    _mm256_storeu_pd(rows, high_temp_row);
+    result->highest_temp = foldLanes(lanes[0], rows, 4, 0);
+    _mm256_storeu_pd(lanes[0], low_temp);
+    _mm256_storeu_pd(rows, low_temp_row);
+    result->lowest_temp = foldLanes(lanes[0], rows, 4, 1);
+    _mm256_storeu_pd(lanes[0], high_wind);
+    _mm256_storeu_pd(rows, high_wind_row);
+    result->strongest_wind = foldLanes(lanes[0], rows, 4, 0);
+    _mm256_storeu_pd(lanes[0], high_humidity);
+    _mm256_storeu_pd(rows, high_humidity_row);
+    result->highest_humidity = foldLanes(lanes[0], rows, 4, 0);
+    result->temp_rows = result->humidity_rows = result->pressure_rows = vectorized;
+
+    // --- the last few rows ---
+    reduceWeatherRows(table, vectorized, result);
+}
+
+__attribute__((target("sse2")))
+static inline __m128d blendSse2(__m128d old, __m128d new, __m128d mask) {
+    /*
+     * function for picking new where mask is set and old elsewhere (blendv needs SSE4.1)
+     * */
+    return _mm_or_pd(_mm_and_pd(mask, new), _mm_andnot_pd(mask, old));
+}
+
+__attribute__((target("sse2")))
+void reduceWeatherSse2(const WeatherTable *table, WeatherReduction *result) {
+    /*
+     * Function for reducing the table 2 rows at a time with SSE2, see reduceWeatherAvx2
+     *  @param table: pointer to a table with at least one row and no nulls in the reduced columns
+     *  @param result: where to store the reduction (every field is overwritten)
+     * */
+    int vectorized = table->count & ~1;
+
+    __m128d sum_temp = _mm_setzero_pd(), sum_humidity = _mm_setzero_pd(), sum_pressure = _mm_setzero_pd();
+    __m128d high_temp = _mm_set1_pd(table->temp[0]), low_temp = high_temp;
+    __m128d high_wind = _mm_set1_pd(table->wind_speed[0]);
+    __m128d high_humidity = _mm_set1_pd(table->humidity[0]);
+    __m128d high_temp_row = _mm_setzero_pd(), low_temp_row = _mm_setzero_pd();
+    __m128d high_wind_row = _mm_setzero_pd(), high_humidity_row = _mm_setzero_pd();
+    __m128d row = _mm_set_pd(1, 0), step = _mm_set1_pd(2);
+
+    for (int i = 0; i < vectorized; i += 2) {
+        __m128d temp = _mm_loadu_pd(table->temp + i);
+        __m128d wind = _mm_loadu_pd(table->wind_speed + i);
+        __m128d humidity = _mm_cvtepi32_pd(_mm_loadl_epi64((const __m128i *) (table->humidity + i)));
+        __m128d pressure = _mm_cvtepi32_pd(_mm_loadl_epi64((const __m128i *) (table->pressure + i)));
+
+        sum_temp = _mm_add_pd(sum_temp, temp);
+        sum_humidity = _mm_add_pd(sum_humidity, humidity);
+        sum_pressure = _mm_add_pd(sum_pressure, pressure);
+
+        __m128d mask = _mm_cmpgt_pd(temp, high_temp);
+        high_temp = _mm_max_pd(high_temp, temp);
+        high_temp_row = blendSse2(high_temp_row, row, mask);
+
+        mask = _mm_cmplt_pd(temp, low_temp);
+        low_temp = _mm_min_pd(low_temp, temp);
+        low_temp_row = blendSse2(low_temp_row, row, mask);
+
+        mask = _mm_cmpgt_pd(wind, high_wind);
+        high_wind = _mm_max_pd(high_wind, wind);
+        high_wind_row = blendSse2(high_wind_row, row, mask);
+
+        mask = _mm_cmpgt_pd(humidity, high_humidity);
+        high_humidity = _mm_max_pd(high_humidity, humidity);
+        high_humidity_row = blendSse2(high_humidity_row, row, mask);
+
+        row = _mm_add_pd(row, step);
+    }
+
+    // --- folding the lanes ---
+    double lanes[3][2], rows[2];
+    _mm_storeu_pd(lanes[0], sum_temp);
+    _mm_storeu_pd(lanes[1], sum_humidity);
+    _mm_storeu_pd(lanes[2], sum_pressure);
+    result->total_temp = lanes[0][0] + lanes[0][1];
+    result->total_humidity = (long long) (lanes[1][0] + lanes[1][1]);
+    result->total_pressure = (long long) (lanes[2][0] + lanes[2][1]);
+
+    _mm_storeu_pd(lanes[0], high_temp);
+    _mm_storeu_pd(rows, high_temp_row);
+    result->highest_temp = foldLanes(lanes[0], rows, 2, 0);
+    _mm_storeu_pd(lanes[0], low_temp);
+    _mm_storeu_pd(rows, low_temp_row);
+    result->lowest_temp = foldLanes(lanes[0], rows, 2, 1);
+    _mm_storeu_pd(lanes[0], high_wind);
+    _mm_storeu_pd(rows, high_wind_row);
+    result->strongest_wind = foldLanes(lanes[0], rows, 2, 0);
+    _mm_storeu_pd(lanes[0], high_humidity);
+    _mm_storeu_pd(rows, high_humidity_row);
+    result->highest_humidity = foldLanes(lanes[0], rows, 2, 0);
+    result->temp_rows = result->humidity_rows = result->pressure_rows = vectorized;
+
+    // --- the last row ---
+    reduceWeatherRows(table, vectorized, result);
+}
+#endif
+
+WeatherReduction reduceWeather(const WeatherTable *table) {
+    /*
+     * Function for computing the sums and the four extremes of the table in a single pass
+     *  @param table: pointer to the table
+     * @return: the reduction (zero sums and -1 extremes for an empty table)
+     * */
+    void (*kernel)(const WeatherTable *, WeatherReduction *) = reduceWeatherScalar;
+    WeatherReduction result = {0};
+    result.highest_temp = result.lowest_temp = result.strongest_wind = result.highest_humidity = -1;
+
+    // --- the widest kernel the CPU supports (the check only reads flags filled in at startup); the vector
+    //     kernels do not look at the null mask, so a table with nulls in these columns takes the scalar one ---
+#if defined(__x86_64__) || defined(__i386__)
+    int nulls = table->null_counts[WEATHER_TEMP] + table->null_counts[WEATHER_HUMIDITY] +
+                table->null_counts[WEATHER_PRESSURE] + table->null_counts[WEATHER_WIND_SPEED];
+    if (nulls == 0 && __builtin_cpu_supports("avx2")) {
+        kernel = reduceWeatherAvx2;
+    } else if (nulls == 0 && __builtin_cpu_supports("sse2")) {
+        kernel = reduceWeatherSse2;
+    }
+#endif
+
+    if (table->count > 0) {
+        kernel(table, &result);
+    }
+    return result;
+}
+
+// ------------------------------
+// ----- PARTIAL STATISTICS -----
+// ------------------------------
+int addBasicStatistics(WeatherPartial *partial, const WeatherTable *table) {
+    /*
+     * Function for adding the sums and weather type counts of a table to a partial state
+     *  @param partial: pointer to the partial state
+     *  @param table: pointer to the table
+     * @return: 1 if successful, 0 if out of memory
+     * */
+    WeatherReduction sums = reduceWeather(table);
+    partial->rows += table->count;
+    partial->total_temp += sums.total_temp;
+    partial->total_humidity += sums.total_humidity;
+    partial->total_pressure += sums.total_pressure;
+    partial->temp_rows += sums.temp_rows;
+    partial->humidity_rows += sums.humidity_rows;
+    partial->pressure_rows += sums.pressure_rows;
+
+    return groupWeatherTable(&partial->weather_types, table, GROUP_WEATHER_MAIN, NULL, WEATHER_TEMP);
+}
+
+int mergeWeatherPartial(WeatherPartial *into, const WeatherPartial *from) {
+    /*
+     * Function for merging one partial state into another
+     *  @param into: pointer to the partial state that receives the other
+     *  @param from: pointer to the partial state to add
+     * @return: 1 if successful, 0 if out of memory
+     * */
+    into->rows += from->rows;
+    into->total_temp += from->total_temp;
+    into->total_humidity += from->total_humidity;
+    into->total_pressure += from->total_pressure;
+    into->temp_rows += from->temp_rows;
+    into->humidity_rows += from->humidity_rows;
+    into->pressure_rows += from->pressure_rows;
+    for (int hour = 0; hour < 24; hour++) {
+        into->hour_temp[hour] += from->hour_temp[hour];
+        into->hour_count[hour] += from->hour_count[hour];
+    }
+
+    return mergeGroupBy(&into->weather_types, &from->weather_types);
+}
+
+void freeWeatherPartial(WeatherPartial *partial) {
+    /*
+     * function for releasing a partial state
+     * */
+    freeGroupBy(&partial->weather_types);
+    memset(partial, 0, sizeof(WeatherPartial));
+}
+
+// ----------------------------
+// ----- BASIC STATISTICS -----
+// ----------------------------
+int partialBasicStatistics(const WeatherPartial *partial, BasicStatistics *stats) {
+    /*
+     * Function for turning a partial state into the basic statistics
+     *  @param partial: pointer to the partial state
+     *  @param stats: where to store the statistics, released with freeBasicStatistics even on failure
+     * @return: 1 if successful, 0 if out of memory
+     * */
+    memset(stats, 0, sizeof(BasicStatistics));
+
+    // --- computing averages over the rows that had the field, NAN if none did ---
+    stats->avg_temp = partial->temp_rows ? partial->total_temp / partial->temp_rows : NAN;
+    stats->avg_humidity = partial->humidity_rows ? (double) partial->total_humidity / partial->humidity_rows : NAN;
+    stats->avg_pressure = partial->pressure_rows ? (double) partial->total_pressure / partial->pressure_rows : NAN;
+
+    // --- the statistics get their own copy of the groups, the partial state is usually freed next ---
+    return mergeGroupBy(&stats->weather_types, &partial->weather_types);
+}
+
+int calculateBasicStatistics(const WeatherTable *table, BasicStatistics *stats) {
+    /*
+     * Function for computing the basic statistics
+     *  @param table: pointer to the table
+     *  @param stats: where to store the statistics, released with freeBasicStatistics even on failure
+     * @return: 1 if successful, 0 if out of memory
+     * */
+    WeatherPartial partial = {0};
+    int ok = addBasicStatistics(&partial, table);
+    ok = partialBasicStatistics(&partial, stats) && ok;
+    freeWeatherPartial(&partial);
+
+    return ok;
+}
+
+void freeBasicStatistics(BasicStatistics *stats) {
+    /*
+     * function for releasing the weather type counts of the statistics
+     * */
+    freeGroupBy(&stats->weather_types);
 }
 
 void printBasicStatistics(const BasicStatistics *stats) {
@@ -129,122 +1098,707 @@ void printBasicStatistics(const BasicStatistics *stats) {
     printf("Average Pressure: %.2f hPa\n", stats->avg_pressure);
 
     printf("\nWeather Type Counts:\n");
-    for (int i = 0; i < stats->weather_type_count; i++) {
-        printf("%s: %d\n", stats->weather_types[i].type, stats->weather_types[i].count);
-    }
+    printGroupBy(&stats->weather_types, NULL);
 }
 
 // -------------------------------
 // ----- FILTERING FUNCTIONS -----
 // -------------------------------
-FilteredResults findRecordsByDateRange(DataEntry *entries, int numEntries, long start_timestamp, long end_timestamp) {
+typedef struct {
+    long dt;
+    int row;
+} DatedRow;
+
+int compareDatedRows(const void *a, const void *b) {
     /*
-     * function for finding records by date range
+     * function for ordering rows by dt, keeping the file order on equal dates
      * */
-    FilteredResults results = {NULL, 0};
+    const DatedRow *x = a, *y = b;
+    if (x->dt != y->dt) {
+        return x->dt < y->dt ? -1 : 1;
+    }
+    return (x->row > y->row) - (x->row < y->row);
+}
 
-    // --- allocating memory --
-    results.entries = malloc(numEntries * sizeof(DataEntry));
+int buildDateIndex(WeatherTable *table) {
+    /*
+     * Function for building the list of rows sorted by dt
+     *  @param table: pointer to the table
+     * @return: 1 if successful, 0 if out of memory
+     * */
+    int *by_dt = malloc((table->count ? table->count : 1) * sizeof(int));
+    if (!by_dt) {
+        return 0;
+    }
 
-    for (int i = 0; i < numEntries; i++) {
-        if (entries[i].dt >= start_timestamp && entries[i].dt <= end_timestamp) {
-            results.entries[results.count] = entries[i];
-            results.count++;
+    // --- weather exports are almost always in time order already, then the index is just 0, 1, 2, ... ---
+    int sorted = 1;
+    for (int i = 1; i < table->count && sorted; i++) {
+        sorted = table->dt[i - 1] <= table->dt[i];
+    }
+
+    if (sorted) {
+        for (int i = 0; i < table->count; i++) {
+            by_dt[i] = i;
+        }
+    } else {
+        DatedRow *dated = malloc(table->count * sizeof(DatedRow));
+        if (!dated) {
+            free(by_dt);
+            return 0;
+        }
+        for (int i = 0; i < table->count; i++) {
+            dated[i].dt = table->dt[i];
+            dated[i].row = i;
         }
+        qsort(dated, table->count, sizeof(DatedRow), compareDatedRows);
+        for (int i = 0; i < table->count; i++) {
+            by_dt[i] = dated[i].row;
+        }
+        free(dated);
     }
 
-    results.entries = realloc(results.entries, results.count * sizeof(DataEntry));
+    free(table->by_dt);
+    table->by_dt = by_dt;
+    table->indexed = table->count;
+    return 1;
+}
 
-    return results;
+int firstRowAfter(const WeatherTable *table, long timestamp, int inclusive) {
+    /*
+     * Function for binary searching the date index
+     *  @param table: pointer to a table with an up to date index
+     *  @param timestamp: date to look for
+     *  @param inclusive: 1 to find the first row with dt >= timestamp, 0 for dt > timestamp
+     * @return: position of that row in the index (count if there is none)
+     * */
+    int low = 0, high = table->count;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        long dt = table->dt[table->by_dt[middle]];
+        if (dt < timestamp || (!inclusive && dt == timestamp)) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
 }
 
-FilteredResults findRecordsByWeatherType(DataEntry *entries, int numEntries, const char *weather_type) {
+RowSpan findRecordsByDateRange(WeatherTable *table, long start_timestamp, long end_timestamp) {
+    /*
+     * Function for finding records by date range in O(log n), without copying anything
+     *  @param table: pointer to the table (its date index is built on the first call)
+     *  @param start_timestamp: first date of the range
+     *  @param end_timestamp: last date of the range, included
+     * @return: the matching rows in dt order, an empty span if the index could not be built
+     * */
+    RowSpan span = {NULL, 0};
+    if (table->indexed != table->count || !table->by_dt) {
+        if (!buildDateIndex(table)) {
+            return span;
+        }
+    }
+
+    int first = firstRowAfter(table, start_timestamp, 1);
+    int last = firstRowAfter(table, end_timestamp, 0);
+    span.rows = table->by_dt + first;
+    span.count = last > first ? last - first : 0;
+    return span;
+}
+
+FilteredResults findRecordsByWeatherType(const WeatherTable *table, const char *weather_type) {
     /*
      * function for finding records by weather type
      * */
     FilteredResults results = {NULL, 0};
 
-    // --- allocating memory ---
-    results.entries = malloc(numEntries * sizeof(DataEntry));
+    // --- matching the few distinct names once, then comparing ids ---
+    char *matches = calloc(table->mains.count ? table->mains.count : 1, 1);
+    results.rows = malloc((table->count ? table->count : 1) * sizeof(int));
+    if (!matches || !results.rows) {
+        free(matches);
+        free(results.rows);
+        results.rows = NULL;
+        return results;
+    }
+    for (int id = 0; id < table->mains.count; id++) {
+        matches[id] = strcasecmp(table->mains.strings[id], weather_type) == 0;
+    }
 
-    for (int i = 0; i < numEntries; i++) {
-        if (strcasecmp(entries[i].weather_main, weather_type) == 0) {
-            results.entries[results.count] = entries[i];
+    for (int i = 0; i < table->count; i++) {
+        if (matches[table->weather_main[i]]) {
+            results.rows[results.count] = i;
             results.count++;
         }
     }
 
-    results.entries = realloc(results.entries, results.count * sizeof(DataEntry));
-
+    free(matches);
     return results;
 }
 
 // -----------------------------------
 // ----- EXTREME VALUES ANALYSIS -----
 // -----------------------------------
-ExtremeValues findExtremeValues(DataEntry *entries, int numEntries) {
-    ExtremeValues extremes;
+ExtremeValue extremeAt(const WeatherTable *table, int row, double value) {
+    /*
+     * Function for describing one extreme by its value, row and time
+     *  @param table: pointer to the table
+     *  @param row: row of the extreme, -1 when no row had the field
+     *  @param value: value of the field at that row (ignored for -1)
+     * @return: the extreme, {NAN, -1, 0} for row -1
+     * */
+    if (row < 0) {
+        ExtremeValue none = {NAN, -1, 0};
+        return none;
+    }
+    ExtremeValue extreme = {value, row, table->dt[row]};
+    return extreme;
+}
 
-    // --- initialising with a first entry ---
-    extremes.highest_temp = entries[0];
-    extremes.lowest_temp = entries[0];
-    extremes.strongest_wind = entries[0];
-    extremes.highest_humidity = entries[0];
+ExtremeValues findExtremeValues(const WeatherTable *table) {
+    ExtremeValues extremes = {0};
+    if (table->count == 0) {
+        return extremes;
+    }
+
+    // --- only rows and values are kept, no record is copied ---
+    WeatherReduction rows = reduceWeather(table);
+    int hot = rows.highest_temp, cold = rows.lowest_temp, windy = rows.strongest_wind, humid = rows.highest_humidity;
+    extremes.highest_temp = extremeAt(table, hot, hot >= 0 ? table->temp[hot] : NAN);
+    extremes.lowest_temp = extremeAt(table, cold, cold >= 0 ? table->temp[cold] : NAN);
+    extremes.strongest_wind = extremeAt(table, windy, windy >= 0 ? table->wind_speed[windy] : NAN);
+    extremes.highest_humidity = extremeAt(table, humid, humid >= 0 ? (double) table->humidity[humid] : NAN);
+
+    return extremes;
+}
+
+void printExtremeValue(const char *label, const char *unit, ExtremeValue extreme) {
+    /*
+     * function for printing one extreme with its date, n/a if no row had the field
+     * */
+    if (extreme.row < 0) {
+        printf("%s: n/a\n", label);
+        return;
+    }
+    char date[64];
+    formatTimestamp(extreme.dt, date, sizeof(date));
+    printf("%s: %.2f%s at %s\n", label, extreme.value, unit, date);
+}
+
+void printExtremeValues(const ExtremeValues *extremes) {
+    /*
+     * function for printing the extreme values with their dates
+     * */
+    printf("\nExtreme Values:\n");
+    printExtremeValue("Highest Temperature", "°C", extremes->highest_temp);
+    printExtremeValue("Lowest Temperature", "°C", extremes->lowest_temp);
+    printExtremeValue("Strongest Wind", " m/s", extremes->strongest_wind);
+}
+
+int rankedBefore(RankedRow a, RankedRow b) {
+    /*
+     * function for checking if a ranks before b: a higher key first, the earlier row on ties
+     * */
+    return a.key > b.key || (a.key == b.key && a.row < b.row);
+}
+
+void offerTopK(TopK *top, RankedRow candidate) {
+    /*
+     * Function for offering a row to a bounded heap; it is kept if it beats the worst of the k kept rows
+     *  @param top: pointer to the heap
+     *  @param candidate: the row and its key
+     * */
+    RankedRow *heap = top->rows;
+    int at;
+
+    if (top->count < top->k) {
+        // --- sifting the new row up while it is worse than its parent ---
+        at = top->count++;
+        while (at > 0 && rankedBefore(heap[(at - 1) / 2], candidate)) {
+            heap[at] = heap[(at - 1) / 2];
+            at = (at - 1) / 2;
+        }
+        heap[at] = candidate;
+        return;
+    }
+    if (top->k == 0 || !rankedBefore(candidate, heap[0])) {
+        return;
+    }
+
+    // --- replacing the worst row and sifting the new one down past worse children ---
+    at = 0;
+    while (2 * at + 1 < top->count) {
+        int child = 2 * at + 1;
+        if (child + 1 < top->count && rankedBefore(heap[child], heap[child + 1])) {
+            child++;
+        }
+        if (!rankedBefore(candidate, heap[child])) {
+            break;
+        }
+        heap[at] = heap[child];
+        at = child;
+    }
+    heap[at] = candidate;
+}
+
+int compareRankedRows(const void *a, const void *b) {
+    /*
+     * function for sorting ranked rows best first
+     * */
+    const RankedRow *x = a, *y = b;
+    return rankedBefore(*x, *y) ? -1 : rankedBefore(*y, *x);
+}
+
+void freeTopK(TopK *top) {
+    /*
+     * function for releasing a top-k list
+     * */
+    free(top->rows);
+    top->rows = NULL;
+    top->count = 0;
+}
+
+int findTopExtremes(const WeatherTable *table, int k, TopK tops[EXTREME_KIND_COUNT]) {
+    /*
+     * Function for finding the k hottest, coldest, windiest and most humid rows in one pass
+     *  @param table: pointer to the table
+     *  @param k: rows to keep per kind
+     *  @param tops: where to store one list per ExtremeKind, best first (release them with freeTopK)
+     * @return: 1 if successful, 0 if out of memory
+     * */
+    int ok = 1;
+    for (int kind = 0; kind < EXTREME_KIND_COUNT; kind++) {
+        tops[kind].rows = malloc((k > 0 ? k : 1) * sizeof(RankedRow));
+        tops[kind].count = 0;
+        tops[kind].k = k > 0 ? k : 0;
+        ok = ok && tops[kind].rows;
+    }
+    if (!ok) {
+        for (int kind = 0; kind < EXTREME_KIND_COUNT; kind++) {
+            freeTopK(&tops[kind]);
+        }
+        return 0;
+    }
+
+    // --- most rows lose against the worst kept row right away, so the heaps are rarely touched; a row only
+    //     competes in the lists whose field it has ---
+    for (int i = 0; i < table->count; i++) {
+        if (!isNull(table, i, WEATHER_TEMP)) {
+            offerTopK(&tops[EXTREME_HIGHEST_TEMP], (RankedRow) {table->temp[i], i});
+            offerTopK(&tops[EXTREME_LOWEST_TEMP], (RankedRow) {-table->temp[i], i});
+        }
+        if (!isNull(table, i, WEATHER_WIND_SPEED)) {
+            offerTopK(&tops[EXTREME_STRONGEST_WIND], (RankedRow) {table->wind_speed[i], i});
+        }
+        if (!isNull(table, i, WEATHER_HUMIDITY)) {
+            offerTopK(&tops[EXTREME_HIGHEST_HUMIDITY], (RankedRow) {table->humidity[i], i});
+        }
+    }
+
+    for (int kind = 0; kind < EXTREME_KIND_COUNT; kind++) {
+        qsort(tops[kind].rows, tops[kind].count, sizeof(RankedRow), compareRankedRows);
+    }
+    return 1;
+}
+
+void printTopExtremes(const WeatherTable *table, const TopK tops[EXTREME_KIND_COUNT]) {
+    /*
+     * function for printing the lists made by findTopExtremes
+     * */
+    const char *titles[] = {"Hottest Hours", "Coldest Hours", "Windiest Hours", "Most Humid Hours"};
+    const char *units[] = {"°C", "°C", " m/s", "%"};
+
+    for (int kind = 0; kind < EXTREME_KIND_COUNT; kind++) {
+        printf("\n%s:\n", titles[kind]);
+        for (int i = 0; i < tops[kind].count; i++) {
+            int row = tops[kind].rows[i].row;
+            double value = kind == EXTREME_LOWEST_TEMP ? -tops[kind].rows[i].key : tops[kind].rows[i].key;
+            char date[64];
+            formatTimestamp(table->dt[row], date, sizeof(date));
+            printf("%2d. %.2f%s at %s (row %d)\n", i + 1, value, units[kind], date, row);
+        }
+    }
+}
+
+// ----------------------------
+// ----- CALENDAR BUCKETS -----
+// ----------------------------
+void calendarFields(long seconds, CalendarFields *fields) {
+    /*
+     * Function for splitting a Unix time into the calendar fields the buckets group by, see civilTime
+     *  @param seconds: seconds since 1970-01-01 00:00, already shifted by the timezone for local time
+     *  @param fields: where to store the fields
+     * */
+    CivilTime civil;
+    civilTime(seconds, &civil);
+    fields->year = (int) civil.year;
+    fields->month = civil.month;
+    fields->day_of_year = civil.day_of_year;
+    fields->hour = civil.hour;
+}
+
+int bucketKey(const CalendarFields *fields, BucketGranularity granularity) {
+    /*
+     * function for picking the calendar field a granularity groups by
+     * */
+    switch (granularity) {
+        case BUCKET_HOUR_OF_DAY:
+            return fields->hour;
+        case BUCKET_DAY_OF_YEAR:
+            return fields->day_of_year;
+        case BUCKET_MONTH:
+            return fields->month;
+        default:
+            return fields->year;
+    }
+}
+
+CalendarBucket *bucketTemperatures(const WeatherTable *table, BucketGranularity granularity, int local_time,
+                                   int *bucket_count) {
+    /*
+     * Function for grouping the temperatures by a calendar field and computing mean, min, max and trend of
+     * every group in one pass; rows without a temperature are skipped
+     *  @param table: pointer to the table
+     *  @param granularity: calendar field to group by
+     *  @param local_time: 1 to use dt + timezone, 0 for UTC
+     *  @param bucket_count: where to store the number of non-empty buckets
+     * @return: the non-empty buckets ordered by key (to be freed), NULL if the table is empty or out of memory
+     * */
+    *bucket_count = 0;
+    if (table->count == 0) {
+        return NULL;
+    }
+
+    // --- buckets are indexed by key - first_key; years are not known in advance, so that range can grow ---
+    int first_key = 0, size = 0;
+    CalendarBucket *buckets = NULL;
+    long origin = table->dt[0];
+
+    for (int i = 0; i < table->count; i++) {
+        if (isNull(table, i, WEATHER_TEMP)) {
+            continue;
+        }
+        CalendarFields fields;
+        calendarFields(table->dt[i] + (local_time ? table->timezone[i] : 0), &fields);
+        int key = bucketKey(&fields, granularity);
+
+        if (size == 0 || key < first_key || key >= first_key + size) {
+            int low = size == 0 ? key : (key < first_key ? key : first_key);
+            int high = size == 0 ? key + 1 : (key >= first_key + size ? key + 1 : first_key + size);
+            if (granularity != BUCKET_YEAR) {
+                low = 0;
+                high = 367;
+            }
+            CalendarBucket *grown = calloc(high - low, sizeof(CalendarBucket));
+            if (!grown) {
+                free(buckets);
+                return NULL;
+            }
+            if (size > 0) {
+                memcpy(grown + (first_key - low), buckets, size * sizeof(CalendarBucket));
+            }
+            free(buckets);
+            buckets = grown;
+            first_key = low;
+            size = high - low;
+        }
+
+        CalendarBucket *bucket = &buckets[key - first_key];
+        double temp = table->temp[i], x = (double) (table->dt[i] - origin) / 86400;
+        if (bucket->count == 0 || temp < bucket->min) {
+            bucket->min = temp;
+        }
+        if (bucket->count == 0 || temp > bucket->max) {
+            bucket->max = temp;
+        }
+        bucket->count++;
+        bucket->mean += temp;
+        bucket->sum_x += x;
+        bucket->sum_x2 += x * x;
+        bucket->sum_xy += x * temp;
+    }
+
+    // --- finishing the buckets and packing the non-empty ones to the front ---
+    for (int i = 0; i < size; i++) {
+        CalendarBucket bucket = buckets[i];
+        if (bucket.count == 0) {
+            continue;
+        }
+        double n = (double) bucket.count, sum_y = bucket.mean;
+        double spread = n * bucket.sum_x2 - bucket.sum_x * bucket.sum_x;
+        bucket.key = first_key + i;
+        bucket.mean = sum_y / n;
+        bucket.trend = spread > 0 ? (n * bucket.sum_xy - bucket.sum_x * sum_y) / spread * 365.25 : 0;
+        buckets[(*bucket_count)++] = bucket;
+    }
+
+    return buckets;
+}
+
+void printCalendarBuckets(const CalendarBucket *buckets, int bucket_count, BucketGranularity granularity) {
+    /*
+     * function for printing the buckets made by bucketTemperatures
+     * */
+    const char *names[] = {"Hour", "Day", "Month", "Year"};
+    for (int i = 0; i < bucket_count; i++) {
+        printf("%s %d: Rows = %lld, Avg = %.2f°C, Min = %.2f°C, Max = %.2f°C, Trend = %.4f°C/year\n",
+               names[granularity], buckets[i].key, buckets[i].count, buckets[i].mean, buckets[i].min,
+               buckets[i].max, buckets[i].trend);
+    }
+}
+
+// ---------------------------
+// ----- ROLLING WINDOWS -----
+// ---------------------------
+double rollingValue(const WeatherTable *table, int field, int row) {
+    /*
+     * function for reading the value of a rolling field at a row, NAN if it is null
+     * */
+    switch (field) {
+        case ROLLING_TEMP:
+            return isNull(table, row, WEATHER_TEMP) ? NAN : table->temp[row];
+        case ROLLING_HUMIDITY:
+            return isNull(table, row, WEATHER_HUMIDITY) ? NAN : table->humidity[row];
+        default:
+            return isNull(table, row, WEATHER_WIND_SPEED) ? NAN : table->wind_speed[row];
+    }
+}
+
+typedef struct {
+    int *positions;  // ring of positions in dt order, never more than the rows of one window
+    int mask;        // ring size - 1 (a power of two)
+    int head;        // head and tail only grow; they are wrapped with mask when used
+    int tail;
+} RollingDeque;
+
+void freeRollingSeries(RollingSeries *series) {
+    /*
+     * function for releasing a rolling series
+     * */
+    free(series->dt);
+    free(series->points);
+    memset(series, 0, sizeof(RollingSeries));
+}
+
+int rollingStatistics(WeatherTable *table, const long *widths, int width_count, long step, RollingSeries *series) {
+    /*
+     * Function for computing rolling mean, min and max of temperature, humidity and wind over several window
+     * widths in one pass over the rows in dt order
+     *  @param table: pointer to the table (its date index is built if needed)
+     *  @param widths: window widths in seconds
+     *  @param width_count: number of widths, at most ROLLING_MAX_WIDTHS
+     *  @param step: seconds between output points; a point is emitted at the last row of every step
+     *               (3600 or less gives one point per row of an hourly series)
+     *  @param series: where to store the series, released with freeRollingSeries
+     * @return: 1 if successful, 0 if out of memory or the widths are invalid
+     * */
+    memset(series, 0, sizeof(RollingSeries));
+    if (width_count < 1 || width_count > ROLLING_MAX_WIDTHS || step < 1) {
+        return 0;
+    }
+    // --- a window must hold at least its own row, otherwise the start pointers run past the last row ---
+    for (int w = 0; w < width_count; w++) {
+        if (widths[w] < 1) {
+            return 0;
+        }
+    }
+    if ((table->indexed != table->count || !table->by_dt) && !buildDateIndex(table)) {
+        return 0;
+    }
+    series->width_count = width_count;
+    memcpy(series->widths, widths, width_count * sizeof(long));
+
+    int n = table->count;
+    size_t slots = n > 0 ? (size_t) n : 1;
+    const int *by_dt = table->by_dt;
+    const long *dt = table->dt;
+
+    // --- counting the points first, so the series is allocated once ---
+    int points = 0;
+    for (int p = 0; p < n; p++) {
+        points += p == n - 1 || dt[by_dt[p + 1]] / step != dt[by_dt[p]] / step;
+    }
+
+    int deque_count = width_count * ROLLING_FIELD_COUNT * 2;
+    RollingDeque *deques = calloc(deque_count, sizeof(RollingDeque));
+    double *values = malloc(slots * ROLLING_FIELD_COUNT * sizeof(double));
+    series->dt = malloc((points ? points : 1) * sizeof(long));
+    series->points = malloc((points ? points : 1) * width_count * ROLLING_FIELD_COUNT * sizeof(RollingPoint));
+    int ok = deques && values && series->dt && series->points;
+
+    // --- sizing every deque to the most rows a window of its width ever holds (24 for a day of hourly rows) ---
+    for (int w = 0; ok && w < width_count; w++) {
+        int widest = 1;
+        for (int p = 0, first = 0; p < n; p++) {
+            while (dt[by_dt[first]] <= dt[by_dt[p]] - widths[w]) {
+                first++;
+            }
+            widest = p - first + 1 > widest ? p - first + 1 : widest;
+        }
+        int size = 1;
+        while (size < widest) {
+            size *= 2;
+        }
+        for (int d = w * ROLLING_FIELD_COUNT * 2; ok && d < (w + 1) * ROLLING_FIELD_COUNT * 2; d++) {
+            deques[d].positions = malloc(size * sizeof(int));
+            deques[d].mask = size - 1;
+            ok = deques[d].positions != NULL;
+        }
+    }
+
+    // --- the fields are gathered in dt order once, so the windows only read contiguous arrays; null fields
+    //     become NAN and stay out of the sums and the deques ---
+    for (int f = 0; ok && f < ROLLING_FIELD_COUNT; f++) {
+        for (int p = 0; p < n; p++) {
+            values[f * n + p] = rollingValue(table, f, by_dt[p]);
+        }
+    }
+
+    int start[ROLLING_MAX_WIDTHS] = {0};
+    double sums[ROLLING_MAX_WIDTHS][ROLLING_FIELD_COUNT] = {{0}};
+    int present[ROLLING_MAX_WIDTHS][ROLLING_FIELD_COUNT] = {{0}};
+
+    for (int p = 0; ok && p < n; p++) {
+        int row = by_dt[p];
+        int emit = p == n - 1 || dt[by_dt[p + 1]] / step != dt[row] / step;
+
+        for (int w = 0; w < width_count; w++) {
+            // --- dropping the rows that fell out of the window from the running sums ---
+            while (dt[by_dt[start[w]]] <= dt[row] - widths[w]) {
+                for (int f = 0; f < ROLLING_FIELD_COUNT; f++) {
+                    double dropped = values[f * n + start[w]];
+                    if (!isnan(dropped)) {
+                        sums[w][f] -= dropped;
+                        present[w][f]--;
+                    }
+                }
+                start[w]++;
+            }
+
+            for (int f = 0; f < ROLLING_FIELD_COUNT; f++) {
+                const double *field = values + f * n;
+                double value = field[p];
+                int has_value = !isnan(value);
+                if (has_value) {
+                    sums[w][f] += value;
+                    present[w][f]++;
+                }
+
+                // --- monotonic deques: a row that can never be the min (or max) again is dropped from the back,
+                //     rows that left the window from the front ---
+                RollingDeque *low = &deques[(w * ROLLING_FIELD_COUNT + f) * 2];
+                RollingDeque *high = low + 1;
+                while (has_value && low->tail > low->head &&
+                       field[low->positions[(low->tail - 1) & low->mask]] >= value) {
+                    low->tail--;
+                }
+                while (low->head < low->tail && low->positions[low->head & low->mask] < start[w]) {
+                    low->head++;
+                }
+                if (has_value) {
+                    low->positions[low->tail++ & low->mask] = p;
+                }
+                while (has_value && high->tail > high->head &&
+                       field[high->positions[(high->tail - 1) & high->mask]] <= value) {
+                    high->tail--;
+                }
+                while (high->head < high->tail && high->positions[high->head & high->mask] < start[w]) {
+                    high->head++;
+                }
+                if (has_value) {
+                    high->positions[high->tail++ & high->mask] = p;
+                }
 
-    for (int i = 1; i < numEntries; i++) {
-        // --- highest temperature ---
-        if (entries[i].temp > extremes.highest_temp.temp) {
-            extremes.highest_temp = entries[i];
+                // --- a window where every row is null gets NAN ---
+                if (emit) {
+                    RollingPoint *point = &series->points[(series->count * width_count + w) * ROLLING_FIELD_COUNT + f];
+                    int empty = low->head == low->tail;
+                    point->mean = empty ? NAN : (float) (sums[w][f] / present[w][f]);
+                    point->min = empty ? NAN : (float) field[low->positions[low->head & low->mask]];
+                    point->max = empty ? NAN : (float) field[high->positions[high->head & high->mask]];
+                }
+            }
         }
 
-        // --- lowest temperature ---
-        if (entries[i].temp < extremes.lowest_temp.temp) {
-            extremes.lowest_temp = entries[i];
+        if (emit) {
+            series->dt[series->count++] = dt[row];
         }
+    }
 
-        // --- strongest wind ---
-        if (entries[i].wind_speed > extremes.strongest_wind.wind_speed) {
-            extremes.strongest_wind = entries[i];
-        }
+    for (int d = 0; deques && d < deque_count; d++) {
+        free(deques[d].positions);
+    }
+    free(deques);
+    free(values);
+    if (!ok) {
+        freeRollingSeries(series);
+    }
+    return ok;
+}
 
-        // --- highest humidity ---
-        if (entries[i].humidity > extremes.highest_humidity.humidity) {
-            extremes.highest_humidity = entries[i];
+void printRollingSeries(const RollingSeries *series, int last) {
+    /*
+     * Function for printing the last points of a rolling series, one line per point and window
+     *  @param series: pointer to the series
+     *  @param last: number of points to print, from the end
+     * */
+    const char *fields[] = {"Temp", "Humidity", "Wind"};
+    int first = series->count > last ? series->count - last : 0;
+
+    for (int i = first; i < series->count; i++) {
+        char date[64];
+        formatTimestamp(series->dt[i], date, sizeof(date));
+        for (int w = 0; w < series->width_count; w++) {
+            printf("%s [%ldh]", date, series->widths[w] / 3600);
+            for (int f = 0; f < ROLLING_FIELD_COUNT; f++) {
+                const RollingPoint *point = &series->points[(i * series->width_count + w) * ROLLING_FIELD_COUNT + f];
+                if (isnan(point->mean)) {
+                    printf("  %s n/a", fields[f]);
+                } else {
+                    printf("  %s %.2f (%.2f..%.2f)", fields[f], point->mean, point->min, point->max);
+                }
+            }
+            printf("\n");
         }
     }
-
-    return extremes;
 }
 
 // ---------------------------
 // ----- HOURLY ANALYSIS -----
 // ---------------------------
-HourlyAnalysis *calculateHourlyTemperatures(DataEntry *entries, int numEntries, int *num_hours) {
+void addHourlyTemperatures(WeatherPartial *partial, const WeatherTable *table) {
+    /*
+     * function for adding the temperatures of a table to the hourly sums of a partial state, skipping null ones
+     * */
+    for (int i = 0; i < table->count; i++) {
+        if (isNull(table, i, WEATHER_TEMP)) {
+            continue;
+        }
+        // extracting the hour of dt_iso, which is dt in UTC
+        CalendarFields fields;
+        calendarFields(table->dt[i], &fields);
+
+        int hour = fields.hour;
+        partial->hour_temp[hour] += table->temp[i];
+        partial->hour_count[hour]++;
+    }
+}
+
+HourlyAnalysis *partialHourlyTemperatures(const WeatherPartial *partial, int *num_hours) {
     HourlyAnalysis *hourly_temps = malloc(24 * sizeof(HourlyAnalysis));
     *num_hours = 0;
 
     for (int i = 0; i < 24; i++) {
         hourly_temps[i].hour = i;
-        hourly_temps[i].avg_temp = 0;
+        hourly_temps[i].avg_temp = partial->hour_temp[i];
         hourly_temps[i].temp_trend = 0;
     }
 
-    int hour_counts[24] = {0};
-    for (int i = 0; i < numEntries; i++) {
-        // extracting hour from the dt_iso
-        struct tm tm;
-        memset(&tm, 0, sizeof(struct tm));
-        strptime(entries[i].dt_iso, "%Y-%m-%d %H:%M:%S", &tm);
-
-        int hour = tm.tm_hour;
-        hourly_temps[hour].avg_temp += entries[i].temp;
-        hour_counts[hour]++;
-    }
-
     // --- computing averages ---
     for (int i = 0; i < 24; i++) {
-        if (hour_counts[i] > 0) {
-            hourly_temps[i].avg_temp /= hour_counts[i];
+        if (partial->hour_count[i] > 0) {
+            hourly_temps[i].avg_temp /= partial->hour_count[i];
             *num_hours += 1;
         }
     }
@@ -254,7 +1808,7 @@ HourlyAnalysis *calculateHourlyTemperatures(DataEntry *entries, int numEntries,
         double sum_x = 0, sum_y = 0, sum_xy = 0, sum_x2 = 0;
 
         for (int i = 0; i < 24; i++) {
-            if (hour_counts[i] > 0) {
+            if (partial->hour_count[i] > 0) {
                 sum_x += i;
                 sum_y += hourly_temps[i].avg_temp;
                 sum_xy += i * hourly_temps[i].avg_temp;
@@ -274,6 +1828,15 @@ HourlyAnalysis *calculateHourlyTemperatures(DataEntry *entries, int numEntries,
     return hourly_temps;
 }
 
+HourlyAnalysis *calculateHourlyTemperatures(const WeatherTable *table, int *num_hours) {
+    WeatherPartial partial = {0};
+    addHourlyTemperatures(&partial, table);
+    HourlyAnalysis *hourly_temps = partialHourlyTemperatures(&partial, num_hours);
+    freeWeatherPartial(&partial);
+
+    return hourly_temps;
+}
+
 // ----------------------------------
 // ----- DATA ENTRIES FUNCTIONS -----
 // ----------------------------------
@@ -315,9 +1878,9 @@ void printDataEntry(const DataEntry *entry) {
     printf("\n");
 }
 
-DataEntry *readCSVFile(const char *filename, int *numEntries) {
+WeatherTable *readCSVFile(const char *filename) {
     /*
-     * function for parsing the CSV
+     * function for parsing the CSV into a column-oriented table
      * */
     FILE *file = fopen(filename, "r");
     if (!file) {
@@ -325,77 +1888,189 @@ DataEntry *readCSVFile(const char *filename, int *numEntries) {
         return NULL;
     }
 
-    // --- allocating initial memory for initial entries ---
-    int capacity = 10;
-    DataEntry *entries = malloc(capacity * sizeof(DataEntry));
-    *numEntries = 0;
-
-    char line[1024];
-
-    // --- skipping header line ---
-    fgets(line, sizeof(line), file);
-
-    // --- reading each line ---
-    while (fgets(line, sizeof(line), file)) {
-        if (*numEntries >= capacity) {
-            capacity *= 2;
-            entries = realloc(entries, capacity * sizeof(DataEntry));
-        }
-
-        DataEntry *entry = &entries[*numEntries];
-
-        sscanf(line,
-               "%ld,%63[^,],%d,%99[^,],%lf,%lf,%lf,%d,%lf,%lf,%lf,%lf,%d,%*[^,],%*[^,],%d,%lf,%d,%lf,%lf,%lf,%lf,%lf,%d,%d,%49[^,],%99[^,],%9[^\n]",
-               &entry->dt,
-               entry->dt_iso,
-               &entry->timezone,
-               entry->city_name,
-               &entry->lat,
-               &entry->lon,
-               &entry->temp,
-               &entry->visibility,
-               &entry->dew_point,
-               &entry->feels_like,
-               &entry->temp_min,
-               &entry->temp_max,
-               &entry->pressure,
-               &entry->humidity,
-               &entry->wind_speed,
-               &entry->wind_deg,
-               &entry->wind_gust,
-               &entry->rain_1h,
-               &entry->rain_3h,
-               &entry->snow_1h,
-               &entry->snow_3h,
-               &entry->clouds_all,
-               &entry->weather_id,
-               entry->weather_main,
-               entry->weather_description,
-               entry->weather_icon);
-
-        (*numEntries)++;
+    WeatherTable *table = calloc(1, sizeof(WeatherTable));
+    if (!table) {
+        fclose(file);
+        return NULL;
+    }
+
+    // --- reading big blocks and cutting them into lines in place, instead of copying every line out ---
+    size_t capacity = 1 << 20, used = 0;
+    char *buffer = malloc(capacity + 1);
+    int ok = buffer != NULL, header = 1;
+    while (ok) {
+        size_t got = fread(buffer + used, 1, capacity - used, file);
+        used += got;
+        buffer[used] = '\0';
+
+        char *line = buffer, *end;
+        while (ok && (end = memchr(line, '\n', buffer + used - line)) != NULL) {
+            *end = '\0';
+            ok = header || *line == '\0' || *line == '\r' || appendCsvLine(table, line);
+            header = 0;
+            line = end + 1;
+        }
+
+        // --- at the end of the file the last line may have no line break ---
+        size_t rest = buffer + used - line;
+        if (got == 0) {
+            ok = ok && (header || rest == 0 || *line == '\r' || appendCsvLine(table, line));
+            break;
+        }
+
+        // --- moving the unfinished line to the front, growing the buffer for very long lines ---
+        memmove(buffer, line, rest);
+        used = rest;
+        if (ok && used == capacity) {
+            char *bigger = realloc(buffer, 2 * capacity + 1);
+            ok = bigger != NULL;
+            if (ok) {
+                buffer = bigger;
+                capacity *= 2;
+            }
+        }
+    }
+    free(buffer);
+
+    if (!ok) {
+        printf("Error: not enough memory for %s\n", filename);
+        freeWeatherTable(table);
+        fclose(file);
+        return NULL;
     }
 
     fclose(file);
-    return entries;
+    return table;
 }
 
 // ------------------------------
 // ----- HISTOGRAM FUNCTIONS ----
 // ------------------------------
-void drawHorizontalHistogram(const char *title, const char *labels[], double values[], int count, int max_width) {
+int chartReserve(ChartBuffer *buffer, size_t extra) {
+    /*
+     * Function to make room for extra bytes at the end of a chart buffer
+     *  @param buffer: pointer to ChartBuffer struct
+     *  @param extra: bytes about to be appended
+     *  @return: 1 if there is room, 0 if the allocation failed
+     * */
+    if (buffer->length + extra <= buffer->capacity) {
+        return 1;
+    }
+
+    size_t capacity = buffer->capacity ? buffer->capacity : 256;
+    while (capacity < buffer->length + extra) {
+        capacity *= 2;
+    }
+
+    char *data = realloc(buffer->data, capacity);
+    if (!data) {
+        return 0;
+    }
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return 1;
+}
+
+int chartPrintf(ChartBuffer *buffer, const char *format, ...) {
+    /*
+     * Function to append formatted text to a chart buffer, like printf
+     *  @param buffer: pointer to ChartBuffer struct
+     *  @param format: printf format string
+     *  @return: 1 on success, 0 on failure
+     * */
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer->data + buffer->length, buffer->capacity - buffer->length, format, args);
+    va_end(args);
+    if (length < 0) {
+        return 0;
+    }
+
+    // --- only grows when the estimate in drawHorizontalHistogram was too small ---
+    if ((size_t) length >= buffer->capacity - buffer->length) {
+        if (!chartReserve(buffer, (size_t) length + 1)) {
+            return 0;
+        }
+        va_start(args, format);
+        vsnprintf(buffer->data + buffer->length, buffer->capacity - buffer->length, format, args);
+        va_end(args);
+    }
+    buffer->length += (size_t) length;
+    return 1;
+}
+
+int chartRepeat(ChartBuffer *buffer, const char *text, int times) {
+    /*
+     * Function to append text to a chart buffer several times, used for the bars
+     *  @param buffer: pointer to ChartBuffer struct
+     *  @param text: text to repeat
+     *  @param times: how many times
+     *  @return: 1 on success, 0 on failure
+     * */
+    size_t length = strlen(text);
+    if (times <= 0) {
+        return 1;
+    }
+    if (!chartReserve(buffer, length * (size_t) times + 1)) {
+        return 0;
+    }
+    for (int i = 0; i < times; i++) {
+        memcpy(buffer->data + buffer->length, text, length);
+        buffer->length += length;
+    }
+    buffer->data[buffer->length] = '\0';
+    return 1;
+}
+
+int chartQuoted(ChartBuffer *buffer, const char *text, ChartFormat format) {
+    /*
+     * Function to append a quoted CSV field or JSON string to a chart buffer
+     *  @param buffer: pointer to ChartBuffer struct
+     *  @param text: text to quote
+     *  @param format: CHART_CSV doubles the quotes, CHART_JSON escapes them
+     *  @return: 1 on success, 0 on failure
+     * */
+    // --- every byte becomes at most 6 (\u001f), plus the quotes ---
+    if (!chartReserve(buffer, strlen(text) * 6 + 3)) {
+        return 0;
+    }
+
+    char *out = buffer->data + buffer->length;
+    *out++ = '"';
+    for (const unsigned char *c = (const unsigned char *) text; *c; c++) {
+        if (format == CHART_CSV) {
+            if (*c == '"') {
+                *out++ = '"';
+            }
+            *out++ = (char) *c;
+        } else if (*c == '"' || *c == '\\') {
+            *out++ = '\\';
+            *out++ = (char) *c;
+        } else if (*c < 0x20) {
+            out += sprintf(out, "\\u%04x", *c);
+        } else {
+            *out++ = (char) *c;
+        }
+    }
+    *out++ = '"';
+    *out = '\0';
+    buffer->length = (size_t) (out - buffer->data);
+    return 1;
+}
+
+int renderHistogram(ChartBuffer *buffer, const char *title, const char *labels[], const double values[], int count,
+                    int max_width, ChartFormat format) {
     /*
-     * Function to draw a horizontal bar chart in the terminal
+     * Function to compose a horizontal bar chart into a buffer, as bars, CSV rows or a JSON object
+     *  @param buffer: pointer to ChartBuffer struct, the chart is appended to it
      *  @param title: title of the histogram
      *  @param labels: array of labels for each bar
      *  @param values: array of values for each bar
      *  @param count: number of bars
      *  @param max_width: maximum width of the histogram
+     *  @param format: CHART_BARS, CHART_CSV or CHART_JSON
+     *  @return: 1 on success, 0 on failure
      * */
-    printf("\n%s\n", title);
-    printf("------------------------------\n");
-
-
     // --- finding the maximum value for scaling ---
     double max_value = 0;
     for (int i = 0; i < count; i++) {
@@ -404,58 +2079,130 @@ void drawHorizontalHistogram(const char *title, const char *labels[], double val
         }
     }
 
-    // --- drawing each bar ---
+    // --- CSV rows carry the title in every row, their header comes from drawChartHeader ---
+    int ok = 1;
+    if (format == CHART_BARS) {
+        ok = chartPrintf(buffer, "\n%s\n------------------------------\n", title);
+    } else if (format == CHART_JSON) {
+        ok = chartPrintf(buffer, "{\"chart\":") && chartQuoted(buffer, title, format) &&
+             chartPrintf(buffer, ",\"bars\":[");
+    }
+
+    // --- one bar, CSV row or JSON object per value ---
+    for (int i = 0; i < count && ok; i++) {
+        int bar_length = max_value > 0 && values[i] > 0 ? (int) ((values[i] / max_value) * max_width) : 0;
+
+        if (format == CHART_BARS) {
+            ok = chartPrintf(buffer, "%-15s [%6.2f] |", labels[i], values[i]) &&
+                 chartRepeat(buffer, "█", bar_length) &&
+                 chartPrintf(buffer, "\n");
+        } else if (format == CHART_CSV) {
+            ok = chartQuoted(buffer, title, format) && chartPrintf(buffer, ",") &&
+                 chartQuoted(buffer, labels[i], format) &&
+                 (isfinite(values[i]) ? chartPrintf(buffer, ",%.6g,%d\n", values[i], bar_length)
+                                      : chartPrintf(buffer, ",,%d\n", bar_length));
+        } else {
+            ok = chartPrintf(buffer, "%s{\"label\":", i ? "," : "") &&
+                 chartQuoted(buffer, labels[i], format) &&
+                 (isfinite(values[i]) ? chartPrintf(buffer, ",\"value\":%.6g", values[i])
+                                      : chartPrintf(buffer, ",\"value\":null")) &&
+                 chartPrintf(buffer, ",\"bar\":%d}", bar_length);
+        }
+    }
+
+    if (ok) {
+        ok = format == CHART_BARS ? chartPrintf(buffer, "\n") :
+             format == CHART_JSON ? chartPrintf(buffer, "]}\n") : 1;
+    }
+    return ok;
+}
+
+void drawHorizontalHistogram(const char *title, const char *labels[], double values[], int count, int max_width,
+                             ChartFormat format) {
+    /*
+     * Function to draw a horizontal bar chart in the terminal with a single write
+     *  @param title: title of the histogram
+     *  @param labels: array of labels for each bar
+     *  @param values: array of values for each bar
+     *  @param count: number of bars
+     *  @param max_width: maximum width of the histogram
+     *  @param format: CHART_BARS, CHART_CSV or CHART_JSON
+     * */
+    // --- sized for the whole chart up front: label, value and a full bar of 3 byte glyphs per line ---
+    size_t estimate = strlen(title) * 8 + 128;
     for (int i = 0; i < count; i++) {
-        int bar_length = (int)((values[i] / max_value) * max_width);
+        estimate += strlen(labels[i]) * 6 + strlen(title) * 2 + 64 + (size_t) (max_width > 0 ? max_width : 0) * 3;
+    }
 
-        // Print the label
-        printf("%-15s [%6.2f] |", labels[i], values[i]);
+    ChartBuffer buffer = {0};
+    if (!chartReserve(&buffer, estimate)) {
+        return;
+    }
+    buffer.data[0] = '\0';
 
-        // Print the bar
-        for (int j = 0; j < bar_length; j++) {
-            printf("█");
-        }
-        printf("\n");
+    if (renderHistogram(&buffer, title, labels, values, count, max_width, format)) {
+        fflush(stdout);
+        fwrite(buffer.data, 1, buffer.length, stdout);
+    }
+    free(buffer.data);
+}
+
+void drawChartHeader(ChartFormat format) {
+    /*
+     * function for printing what comes once before all the charts of a run: the CSV header, nothing otherwise
+     * */
+    if (format == CHART_CSV) {
+        printf("chart,label,value,bar\n");
     }
-    printf("\n");
 }
 
-void drawWeatherTypeHistogram(const BasicStatistics *stats) {
+void drawWeatherTypeHistogram(const BasicStatistics *stats, ChartFormat format) {
     /*
      * Function to draw weather type distribution histogram
      *  @param stats: pointer to BasicStatistics struct
+     *  @param format: CHART_BARS, CHART_CSV or CHART_JSON
      * */
-    const char *labels[10];
-    double values[10];
+    const GroupBy *types = &stats->weather_types;
+    const char **labels = malloc((types->keys.count ? types->keys.count : 1) * sizeof(char *));
+    double *values = malloc((types->keys.count ? types->keys.count : 1) * sizeof(double));
+    if (!labels || !values) {
+        free(labels);
+        free(values);
+        return;
+    }
 
-    for (int i = 0; i < stats->weather_type_count; i++) {
-        labels[i] = stats->weather_types[i].type;
-        values[i] = (double)stats->weather_types[i].count;
+    for (int i = 0; i < types->keys.count; i++) {
+        labels[i] = types->keys.strings[i];
+        values[i] = (double) types->counts[i];
     }
 
-    drawHorizontalHistogram("Weather Type Distribution", labels, values, stats->weather_type_count, 50);
+    drawHorizontalHistogram("Weather Type Distribution", labels, values, types->keys.count, 50, format);
+    free(labels);
+    free(values);
 }
 
-void drawExtremeValuesHistogram(const ExtremeValues *extremes) {
+void drawExtremeValuesHistogram(const ExtremeValues *extremes, ChartFormat format) {
     /*
      * Function to draw extreme values comparison
      *  @param extremes: pointer to ExtremeValues struct
+     *  @param format: CHART_BARS, CHART_CSV or CHART_JSON
      * */
     const char *labels[] = {"Highest Temp", "Lowest Temp", "Strongest Wind", "Highest Humidity"};
     double values[] = {
-            extremes->highest_temp.temp,
-            extremes->lowest_temp.temp,
-            extremes->strongest_wind.wind_speed,
-            (double)extremes->highest_humidity.humidity
+            extremes->highest_temp.value,
+            extremes->lowest_temp.value,
+            extremes->strongest_wind.value,
+            extremes->highest_humidity.value
     };
 
-    drawHorizontalHistogram("Extreme Values", labels, values, 4, 40);
+    drawHorizontalHistogram("Extreme Values", labels, values, 4, 40, format);
 }
 
-void drawBasicStatsHistogram(const BasicStatistics *stats) {
+void drawBasicStatsHistogram(const BasicStatistics *stats, ChartFormat format) {
     /*
      * Function to draw temperature, humidity, pressure comparison
      *  @param stats: pointer to BasicStatistics struct
+     *  @param format: CHART_BARS, CHART_CSV or CHART_JSON
      * */
 
     const char *labels[] = {"Avg Temperature (°C)", "Avg Humidity (%)", "Avg Pressure (hPa/10)"};
@@ -465,9 +2212,516 @@ void drawBasicStatsHistogram(const BasicStatistics *stats) {
             stats->avg_pressure / 10  // Scaled down to fit on the same scale
     };
 
-    drawHorizontalHistogram("Basic Weather Statistics", labels, values, 3, 40);
+    drawHorizontalHistogram("Basic Weather Statistics", labels, values, 3, 40, format);
+}
+
+
+// ------------------------------------
+// ----- INCREMENTAL AGGREGATION -----
+// ------------------------------------
+#define CHECKPOINT_MAGIC "WAGG"
+#define CHECKPOINT_VERSION 4
+#define FEED_PREFIX_BYTES 4096
+
+void welfordUpdate(double *mean, double *m2, long long count, double value) {
+    /*
+     * function for adding the count-th value to a running mean and sum of squared differences
+     * */
+    double delta = value - *mean;
+    *mean += delta / (double) count;
+    *m2 += delta * (value - *mean);
+}
+
+int updateAggregator(WeatherAggregator *aggregator, const DataEntry *entry, unsigned int nulls) {
+    /*
+     * Function for adding one observation to the running statistics in O(1)
+     *  @param aggregator: pointer to the aggregator (all zero for a fresh one)
+     *  @param entry: the observation
+     *  @param nulls: null mask of the observation (bit f set if WeatherField f was blank), as parseWeatherLine
+     *                returns it; null fields are left out of the statistics
+     * @return: 1 if successful, 0 if out of memory
+     * */
+    AggregatorState *state = &aggregator->state;
+    int weather_main = groupByAdd(&aggregator->weather_types, entry->weather_main, strlen(entry->weather_main), 1, 0, 0);
+    if (weather_main < 0) {
+        return 0;
+    }
+
+    state->rows++;
+    if (entry->dt > state->last_dt || state->rows == 1) {
+        state->last_dt = entry->dt;
+    }
+
+    // --- every field keeps its own count, so a blank one does not drag the mean towards 0; strict compares keep
+    //     the earliest observation on ties, like findExtremeValues ---
+    ExtremeValues *extremes = &state->extremes;
+    int observation = (int) (state->rows - 1);
+    if (!(nulls >> WEATHER_TEMP & 1)) {
+        state->temp_rows++;
+        welfordUpdate(&state->temp_mean, &state->temp_m2, state->temp_rows, entry->temp);
+        if (state->temp_rows == 1 || entry->temp > extremes->highest_temp.value) {
+            extremes->highest_temp = (ExtremeValue) {entry->temp, observation, entry->dt};
+        }
+        if (state->temp_rows == 1 || entry->temp < extremes->lowest_temp.value) {
+            extremes->lowest_temp = (ExtremeValue) {entry->temp, observation, entry->dt};
+        }
+
+        CalendarFields fields;
+        calendarFields(entry->dt, &fields);
+        state->hour_temp[fields.hour] += entry->temp;
+        state->hour_count[fields.hour]++;
+    }
+    if (!(nulls >> WEATHER_HUMIDITY & 1)) {
+        state->humidity_rows++;
+        welfordUpdate(&state->humidity_mean, &state->humidity_m2, state->humidity_rows, entry->humidity);
+        if (state->humidity_rows == 1 || entry->humidity > extremes->highest_humidity.value) {
+            extremes->highest_humidity = (ExtremeValue) {entry->humidity, observation, entry->dt};
+        }
+    }
+    if (!(nulls >> WEATHER_PRESSURE & 1)) {
+        state->pressure_rows++;
+        welfordUpdate(&state->pressure_mean, &state->pressure_m2, state->pressure_rows, entry->pressure);
+    }
+    if (!(nulls >> WEATHER_WIND_SPEED & 1)) {
+        state->wind_rows++;
+        if (state->wind_rows == 1 || entry->wind_speed > extremes->strongest_wind.value) {
+            extremes->strongest_wind = (ExtremeValue) {entry->wind_speed, observation, entry->dt};
+        }
+    }
+    return 1;
+}
+
+double runningStddev(double m2, long long count) {
+    /*
+     * function for the population standard deviation of a Welford state, NAN without any value
+     * */
+    return count ? sqrt(m2 / (double) count) : NAN;
+}
+
+int snapshotAggregator(const WeatherAggregator *aggregator, WeatherSnapshot *snapshot) {
+    /*
+     * Function for reading the current statistics out of an aggregator, without changing it
+     *  @param aggregator: pointer to the aggregator
+     *  @param snapshot: where to store the statistics, released with freeWeatherSnapshot even on failure
+     * @return: 1 if successful, 0 if out of memory
+     * */
+    const AggregatorState *state = &aggregator->state;
+    memset(snapshot, 0, sizeof(WeatherSnapshot));
+
+    // --- a field that was blank in every observation has no statistics ---
+    snapshot->stats.avg_temp = state->temp_rows ? state->temp_mean : NAN;
+    snapshot->stats.avg_humidity = state->humidity_rows ? state->humidity_mean : NAN;
+    snapshot->stats.avg_pressure = state->pressure_rows ? state->pressure_mean : NAN;
+    int ok = mergeGroupBy(&snapshot->stats.weather_types, &aggregator->weather_types);
+    snapshot->temp_stddev = runningStddev(state->temp_m2, state->temp_rows);
+    snapshot->humidity_stddev = runningStddev(state->humidity_m2, state->humidity_rows);
+    snapshot->pressure_stddev = runningStddev(state->pressure_m2, state->pressure_rows);
+
+    ExtremeValue none = {NAN, -1, 0};
+    snapshot->extremes = state->extremes;
+    if (state->temp_rows == 0) {
+        snapshot->extremes.highest_temp = snapshot->extremes.lowest_temp = none;
+    }
+    if (state->humidity_rows == 0) {
+        snapshot->extremes.highest_humidity = none;
+    }
+    if (state->wind_rows == 0) {
+        snapshot->extremes.strongest_wind = none;
+    }
+
+    // --- the hourly analysis is finished the same way as for a whole table ---
+    WeatherPartial hours = {0};
+    memcpy(hours.hour_temp, state->hour_temp, sizeof(hours.hour_temp));
+    memcpy(hours.hour_count, state->hour_count, sizeof(hours.hour_count));
+    snapshot->hourly = partialHourlyTemperatures(&hours, &snapshot->num_hours);
+
+    return ok;
+}
+
+void freeWeatherSnapshot(WeatherSnapshot *snapshot) {
+    /*
+     * function for releasing a snapshot
+     * */
+    freeBasicStatistics(&snapshot->stats);
+    free(snapshot->hourly);
+    snapshot->hourly = NULL;
+}
+
+void freeAggregator(WeatherAggregator *aggregator) {
+    /*
+     * function for releasing an aggregator
+     * */
+    freeGroupBy(&aggregator->weather_types);
+    memset(aggregator, 0, sizeof(WeatherAggregator));
+}
+
+int saveAggregator(const WeatherAggregator *aggregator, const char *path) {
+    /*
+     * Function for writing a checkpoint of an aggregator; a temporary file is renamed over the old checkpoint,
+     * so a crash while saving leaves the previous one intact
+     *  @param aggregator: pointer to the aggregator
+     *  @param path: path of the checkpoint
+     * @return: 1 if successful, 0 otherwise
+     * */
+    char temporary[4096];
+    snprintf(temporary, sizeof(temporary), "%s.tmp", path);
+    FILE *file = fopen(temporary, "wb");
+    if (!file) {
+        perror("Error opening checkpoint");
+        return 0;
+    }
+
+    int version = CHECKPOINT_VERSION, groups = aggregator->weather_types.keys.count;
+    int ok = fwrite(CHECKPOINT_MAGIC, 4, 1, file) == 1 && fwrite(&version, sizeof(int), 1, file) == 1 &&
+             fwrite(&aggregator->state, sizeof(AggregatorState), 1, file) == 1 &&
+             fwrite(&groups, sizeof(int), 1, file) == 1;
+
+    // --- every weather type as length, name, count, samples and sum ---
+    for (int group = 0; ok && group < groups; group++) {
+        const char *key = aggregator->weather_types.keys.strings[group];
+        int length = (int) strlen(key);
+        ok = fwrite(&length, sizeof(int), 1, file) == 1 && fwrite(key, 1, length, file) == (size_t) length &&
+             fwrite(&aggregator->weather_types.counts[group], sizeof(long long), 1, file) == 1 &&
+             fwrite(&aggregator->weather_types.samples[group], sizeof(long long), 1, file) == 1 &&
+             fwrite(&aggregator->weather_types.sums[group], sizeof(double), 1, file) == 1;
+    }
+
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(temporary, path) != 0) {
+        printf("Error: could not write checkpoint %s\n", path);
+        remove(temporary);
+        return 0;
+    }
+    return 1;
+}
+
+int loadAggregator(WeatherAggregator *aggregator, const char *path) {
+    /*
+     * Function for restoring an aggregator from a checkpoint
+     *  @param aggregator: where to store the aggregator (all zero on entry)
+     *  @param path: path of the checkpoint
+     * @return: 1 if successful, 0 if there is no valid checkpoint (the aggregator is left empty)
+     * */
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return 0;
+    }
+
+    char magic[4];
+    int version, groups;
+    int ok = fread(magic, 4, 1, file) == 1 && memcmp(magic, CHECKPOINT_MAGIC, 4) == 0 &&
+             fread(&version, sizeof(int), 1, file) == 1 && version == CHECKPOINT_VERSION &&
+             fread(&aggregator->state, sizeof(AggregatorState), 1, file) == 1 &&
+             fread(&groups, sizeof(int), 1, file) == 1 && groups >= 0;
+
+    char key[256];
+    for (int group = 0; ok && group < groups; group++) {
+        int length;
+        long long count, samples;
+        double sum;
+        ok = fread(&length, sizeof(int), 1, file) == 1 && length >= 0 && length < (int) sizeof(key) &&
+             fread(key, 1, length, file) == (size_t) length && fread(&count, sizeof(long long), 1, file) == 1 &&
+             fread(&samples, sizeof(long long), 1, file) == 1 && fread(&sum, sizeof(double), 1, file) == 1 &&
+             groupByAdd(&aggregator->weather_types, key, length, count, samples, sum) >= 0;
+    }
+    fclose(file);
+
+    if (!ok) {
+        printf("Warning: ignoring invalid checkpoint %s\n", path);
+        freeAggregator(aggregator);
+    }
+    return ok;
+}
+
+int hashFeedPrefix(FILE *file, long length, unsigned int *hash) {
+    /*
+     * Function for hashing the first bytes of a feed, which never change while rows are only appended
+     *  @param file: the open feed, its position is changed
+     *  @param length: bytes to hash, at most FEED_PREFIX_BYTES
+     *  @param hash: where to store the hash
+     * @return: 1 if the feed has that many bytes, 0 otherwise
+     * */
+    char prefix[FEED_PREFIX_BYTES];
+    if (length < 0 || length > FEED_PREFIX_BYTES) {
+        return 0;
+    }
+    rewind(file);
+    if (fread(prefix, 1, (size_t) length, file) != (size_t) length) {
+        return 0;
+    }
+    *hash = hashString(prefix, (size_t) length);
+    return 1;
+}
+
+int followWeatherFeed(const char *csv_path, const char *checkpoint_path) {
+    /*
+     * Function for adding the rows appended to a feed since the last run, then printing the statistics
+     *  @param csv_path: path of the CSV feed
+     *  @param checkpoint_path: path of the checkpoint, created on the first run
+     * @return: 1 if successful, 0 otherwise
+     * */
+    WeatherAggregator aggregator = {0};
+    int resumed = loadAggregator(&aggregator, checkpoint_path);
+
+    FILE *file = fopen(csv_path, "r");
+    if (!file) {
+        perror("Error opening file");
+        freeAggregator(&aggregator);
+        return 0;
+    }
+
+    // --- resuming where the last run stopped, if this still is the same feed: same file, not shorter, same first
+    //     bytes; a rotated feed is read again and only rows newer than the checkpoint are added ---
+    AggregatorState *state = &aggregator.state;
+    struct stat info;
+    long skip_through = LONG_MIN;
+    unsigned int hash = 0;
+    int same_feed = resumed && fstat(fileno(file), &info) == 0 &&
+                    (unsigned long long) info.st_dev == state->feed_device &&
+                    (unsigned long long) info.st_ino == state->feed_inode &&
+                    fseek(file, 0, SEEK_END) == 0 && ftell(file) >= state->offset &&
+                    hashFeedPrefix(file, state->feed_prefix, &hash) && hash == state->feed_hash;
+    if (same_feed) {
+        fseek(file, aggregator.state.offset, SEEK_SET);
+    } else {
+        skip_through = resumed ? aggregator.state.last_dt : LONG_MIN;
+        rewind(file);
+    }
+
+    char *line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+    long long added = 0;
+    int ok = 1, unfinished = 0;
+    long offset = ftell(file);
+    while (ok && (length = getline(&line, &capacity, file)) > 0) {
+        // --- only the last line can lack its '\n', it is still being written and is left for the next run ---
+        if (line[length - 1] != '\n') {
+            unfinished = 1;
+            break;
+        }
+        offset = ftell(file);
+
+        DataEntry entry = {0};
+        if (line[0] == '\n' || line[0] == '\r' || strncmp(line, "dt,", 3) == 0) {
+            continue;
+        }
+        unsigned int nulls = parseWeatherLine(line, &entry);
+        if (entry.dt <= skip_through) {
+            continue;
+        }
+        ok = updateAggregator(&aggregator, &entry, nulls);
+        added++;
+    }
+    free(line);
+
+    // --- remembering which feed this was, to notice a rotation on the next run ---
+    aggregator.state.offset = offset;
+    if (fstat(fileno(file), &info) == 0) {
+        state->feed_device = (unsigned long long) info.st_dev;
+        state->feed_inode = (unsigned long long) info.st_ino;
+    }
+    state->feed_prefix = offset < FEED_PREFIX_BYTES ? offset : FEED_PREFIX_BYTES;
+    if (!hashFeedPrefix(file, state->feed_prefix, &state->feed_hash)) {
+        state->feed_prefix = 0;
+        state->feed_hash = hashString("", 0);
+    }
+    fclose(file);
+
+    if (!ok) {
+        printf("Error: not enough memory\n");
+    } else if (aggregator.state.rows == 0) {
+        printf("Error: no rows in %s\n", csv_path);
+        ok = 0;
+    } else {
+        ok = saveAggregator(&aggregator, checkpoint_path);
+
+        WeatherSnapshot snapshot;
+        if (!snapshotAggregator(&aggregator, &snapshot)) {
+            printf("Error: not enough memory\n");
+            freeWeatherSnapshot(&snapshot);
+            freeAggregator(&aggregator);
+            return 0;
+        }
+        printf("Aggregated %lld rows (%lld new%s)\n\n", aggregator.state.rows, added,
+               unfinished ? ", the unfinished last line is left for the next run" : "");
+        printBasicStatistics(&snapshot.stats);
+        printf("\nStandard Deviation: Temperature %.2f°C, Humidity %.2f%%, Pressure %.2f hPa\n",
+               snapshot.temp_stddev, snapshot.humidity_stddev, snapshot.pressure_stddev);
+
+        printExtremeValues(&snapshot.extremes);
+
+        printf("\nHourly Temperature Analysis:\n");
+        for (int i = 0; snapshot.hourly && i < snapshot.num_hours; i++) {
+            printf("Hour %d: Avg Temp = %.2f°C, Trend = %.4f\n",
+                   snapshot.hourly[i].hour,
+                   snapshot.hourly[i].avg_temp,
+                   snapshot.hourly[i].temp_trend);
+        }
+        freeWeatherSnapshot(&snapshot);
+    }
+
+    freeAggregator(&aggregator);
+    return ok;
+}
+
+// -------------------------------------
+// ----- PARALLEL MULTI-FILE MODE -----
+// -------------------------------------
+typedef struct {
+    char **files;                  // paths of all files to ingest
+    int file_count;
+    int next_file;                 // next file nobody has taken yet
+    pthread_mutex_t lock;
+} IngestQueue;
+
+typedef struct {
+    IngestQueue *queue;
+    WeatherPartial partial;        // everything this worker has read, merged at the end
+    int ok;
+} IngestWorker;
+
+void *ingestFiles(void *arg) {
+    /*
+     * Function for a worker thread: takes files from the queue until it is empty, reading each one into its own
+     * table and adding it to the worker's partial state
+     *  @param arg: pointer to the IngestWorker
+     * @return: NULL
+     * */
+    IngestWorker *worker = arg;
+    IngestQueue *queue = worker->queue;
+
+    while (worker->ok) {
+        pthread_mutex_lock(&queue->lock);
+        int file = queue->next_file < queue->file_count ? queue->next_file++ : -1;
+        pthread_mutex_unlock(&queue->lock);
+        if (file < 0) {
+            break;
+        }
+
+        // --- an unreadable file is reported by readCSVFile and skipped ---
+        WeatherTable *table = readCSVFile(queue->files[file]);
+        if (table) {
+            worker->ok = addBasicStatistics(&worker->partial, table);
+            addHourlyTemperatures(&worker->partial, table);
+            freeWeatherTable(table);
+        }
+    }
+    return NULL;
 }
 
+int analyzeFiles(const char *source, int thread_count) {
+    /*
+     * Function for ingesting many weather CSVs on a pool of threads and printing the merged statistics
+     *  @param source: a directory (all its *.csv files are read) or a glob pattern
+     *  @param thread_count: number of worker threads, 0 for one per online core
+     * @return: 1 if successful, 0 otherwise
+     * */
+    char pattern[4096];
+    struct stat info;
+    if (stat(source, &info) == 0 && S_ISDIR(info.st_mode)) {
+        snprintf(pattern, sizeof(pattern), "%s/*.csv", source);
+    } else {
+        snprintf(pattern, sizeof(pattern), "%s", source);
+    }
+
+    glob_t found;
+    if (glob(pattern, 0, NULL, &found) != 0 || found.gl_pathc == 0) {
+        printf("Error: no files match %s\n", pattern);
+        globfree(&found);
+        return 0;
+    }
+
+    if (thread_count <= 0) {
+        thread_count = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (thread_count > (int) found.gl_pathc) {
+        thread_count = (int) found.gl_pathc;
+    }
+    if (thread_count < 1) {
+        thread_count = 1;
+    }
+
+    IngestQueue queue = {found.gl_pathv, (int) found.gl_pathc, 0, PTHREAD_MUTEX_INITIALIZER};
+    IngestWorker *workers = calloc(thread_count, sizeof(IngestWorker));
+    pthread_t *threads = calloc(thread_count, sizeof(pthread_t));
+    if (!workers || !threads) {
+        free(workers);
+        free(threads);
+        globfree(&found);
+        return 0;
+    }
+
+    struct timespec start, stop;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    int started = 0;
+    for (int i = 0; i < thread_count; i++) {
+        workers[i].queue = &queue;
+        workers[i].ok = 1;
+        if (pthread_create(&threads[i], NULL, ingestFiles, &workers[i]) == 0) {
+            started++;
+        } else {
+            break;
+        }
+    }
+    // --- if no thread could start, this thread does the work ---
+    if (started == 0) {
+        ingestFiles(&workers[0]);
+        started = 1;
+    } else {
+        for (int i = 0; i < started; i++) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    // --- merging the partial states of the workers ---
+    WeatherPartial total = {0};
+    int ok = 1;
+    for (int i = 0; i < started; i++) {
+        ok = ok && workers[i].ok && mergeWeatherPartial(&total, &workers[i].partial);
+        freeWeatherPartial(&workers[i].partial);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    double seconds = (double) (stop.tv_sec - start.tv_sec) + (double) (stop.tv_nsec - start.tv_nsec) / 1e9;
+
+    if (!ok) {
+        printf("Error: not enough memory\n");
+    } else if (total.rows == 0) {
+        printf("Error: no rows in %d files\n", queue.file_count);
+        ok = 0;
+    } else {
+        printf("Ingested %lld rows from %d files on %d threads in %.3f s (%.0f rows/sec)\n\n",
+               total.rows, queue.file_count, started, seconds, total.rows / seconds);
+
+        BasicStatistics stats;
+        if (partialBasicStatistics(&total, &stats)) {
+            printBasicStatistics(&stats);
+        } else {
+            printf("Error: not enough memory\n");
+            ok = 0;
+        }
+        freeBasicStatistics(&stats);
+
+        int num_hours;
+        HourlyAnalysis *hourly_temps = partialHourlyTemperatures(&total, &num_hours);
+        printf("\nHourly Temperature Analysis:\n");
+        for (int i = 0; hourly_temps && i < num_hours; i++) {
+            printf("Hour %d: Avg Temp = %.2f°C, Trend = %.4f\n",
+                   hourly_temps[i].hour,
+                   hourly_temps[i].avg_temp,
+                   hourly_temps[i].temp_trend);
+        }
+        free(hourly_temps);
+    }
+
+    freeWeatherPartial(&total);
+    free(workers);
+    free(threads);
+    globfree(&found);
+    return ok;
+}
 
 // -------------------------
 // ----- MENU ELEMENTS -----
@@ -479,14 +2733,27 @@ void showGeneralMenu() {
            "\n3) show extreem values"
            "\n4) show hourly temperature"
            "\n5) show histograms"
+           "\n6) show calendar statistics"
+           "\n7) show weather breakdown"
+           "\n8) show top extreme hours"
+           "\n9) show rolling statistics"
            "\n0) exit\n");
 }
 
-int main() {
-    int numEntries;
-    DataEntry *entries = readCSVFile("inputData/Timisoara.csv", &numEntries);
+int main(int argc, char *argv[]) {
+    // --- lab3 --follow <csv> <checkpoint> adds only the rows appended since the last run ---
+    if (argc > 3 && strcmp(argv[1], "--follow") == 0) {
+        return followWeatherFeed(argv[2], argv[3]) ? 0 : 1;
+    }
+
+    // --- lab3 <directory|glob> [threads] reads many files in parallel instead of the menu ---
+    if (argc > 1) {
+        return analyzeFiles(argv[1], argc > 2 ? atoi(argv[2]) : 0) ? 0 : 1;
+    }
+
+    WeatherTable *table = readCSVFile("inputData/Timisoara.csv");
 
-    if (entries) {
+    if (table) {
         int current_option = -1;
 
         while (current_option != 0) {
@@ -502,29 +2769,36 @@ int main() {
                 printf("interval stop: ");
                 scanf("%d", &interval_stop);
 
-                for (int i = interval_start; i < interval_stop; i++) {
-                    printDataEntry(&entries[i]);
+                // --- the interval is clamped to the rows of the table on both ends ---
+                if (interval_start < 0) {
+                    interval_start = 0;
+                }
+                for (int i = interval_start; i < interval_stop && i < table->count; i++) {
+                    DataEntry entry;
+                    getDataEntry(table, i, &entry);
+                    printDataEntry(&entry);
                     printf("\n");
                 }
 
             } else if (current_option == 2) {
                 // --- showing basic statistics ---
-                BasicStatistics stats = calculateBasicStatistics(entries, numEntries);
-                printBasicStatistics(&stats);
+                BasicStatistics stats;
+                if (calculateBasicStatistics(table, &stats)) {
+                    printBasicStatistics(&stats);
+                } else {
+                    printf("Error: not enough memory\n");
+                }
+                freeBasicStatistics(&stats);
 
             } else if (current_option == 3) {
                 // --- extreme values example ---
-                ExtremeValues extremes = findExtremeValues(entries, numEntries);
-                printf("\nExtreme Values:\n");
-                printf("Highest Temperature: %.2f°C at %s\n", extremes.highest_temp.temp, extremes.highest_temp.dt_iso);
-                printf("Lowest Temperature: %.2f°C at %s\n", extremes.lowest_temp.temp, extremes.lowest_temp.dt_iso);
-                printf("Strongest Wind: %.2f m/s at %s\n", extremes.strongest_wind.wind_speed,
-                       extremes.strongest_wind.dt_iso);
+                ExtremeValues extremes = findExtremeValues(table);
+                printExtremeValues(&extremes);
 
             } else if (current_option == 4) {
                 // --- hourly temperature analysis ---
                 int num_hours;
-                HourlyAnalysis *hourly_temps = calculateHourlyTemperatures(entries, numEntries, &num_hours);
+                HourlyAnalysis *hourly_temps = calculateHourlyTemperatures(table, &num_hours);
 
                 printf("\nHourly Temperature Analysis:\n");
                 for (int i = 0; i < num_hours; i++) {
@@ -537,21 +2811,38 @@ int main() {
                 free(hourly_temps);
 
             } else if (current_option == 5) {
-                // --- displaying histograms ---
-                printf("\n[ACTION] Showing all histograms...\n");
+                // --- displaying histograms, as bars or as CSV/JSON for dashboards ---
+                int format = 1;
+                printf("format (1 bars, 2 csv, 3 json): ");
+                scanf("%d", &format);
+                if (format < 1 || format > 3) {
+                    printf("Invalid format\n");
+                    continue;
+                }
+
+                // --- CSV and JSON go to stdout alone, the messages for people go to stderr ---
+                FILE *messages = format == 1 ? stdout : stderr;
+                fprintf(messages, "\n[ACTION] Showing all histograms...\n");
+                fflush(messages);
+                drawChartHeader(format - 1);
 
                 // --- basic statistics histograms ---
-                BasicStatistics stats = calculateBasicStatistics(entries, numEntries);
-                drawBasicStatsHistogram(&stats);
-                drawWeatherTypeHistogram(&stats);
+                BasicStatistics stats;
+                if (calculateBasicStatistics(table, &stats)) {
+                    drawBasicStatsHistogram(&stats, format - 1);
+                    drawWeatherTypeHistogram(&stats, format - 1);
+                } else {
+                    fprintf(messages, "Error: not enough memory\n");
+                }
+                freeBasicStatistics(&stats);
 
                 // --- extreme values histogram ---
-                ExtremeValues extremes = findExtremeValues(entries, numEntries);
-                drawExtremeValuesHistogram(&extremes);
+                ExtremeValues extremes = findExtremeValues(table);
+                drawExtremeValuesHistogram(&extremes, format - 1);
 
                 // --- hourly temperature histogram ---
                 int num_hours;
-                HourlyAnalysis *hourly_temps = calculateHourlyTemperatures(entries, numEntries, &num_hours);
+                HourlyAnalysis *hourly_temps = calculateHourlyTemperatures(table, &num_hours);
 
                 // --- preparing data for hourly histogram ---
                 const char *labels[24];
@@ -568,13 +2859,76 @@ int main() {
                     }
                 }
 
-                drawHorizontalHistogram("Hourly Temperature Distribution", labels, values, valid_hours, 40);
+                drawHorizontalHistogram("Hourly Temperature Distribution", labels, values, valid_hours, 40, format - 1);
                 free(hourly_temps);
 
+            } else if (current_option == 6) {
+                // --- mean/min/max/trend per calendar bucket, in the local time of every row ---
+                int granularity = 3;
+                printf("group by (1 hour of day, 2 day of year, 3 month, 4 year): ");
+                scanf("%d", &granularity);
+                if (granularity < 1 || granularity > 4) {
+                    printf("Invalid grouping\n");
+                    continue;
+                }
+
+                int bucket_count;
+                CalendarBucket *buckets = bucketTemperatures(table, granularity - 1, 1, &bucket_count);
+                printf("\nCalendar Statistics (local time):\n");
+                printCalendarBuckets(buckets, bucket_count, granularity - 1);
+                free(buckets);
+
+            } else if (current_option == 7) {
+                // --- rows and average temperature per weather type, description or condition id ---
+                int column = 1;
+                printf("group by (1 weather main, 2 weather description, 3 weather id): ");
+                scanf("%d", &column);
+                if (column < 1 || column > 3) {
+                    printf("Invalid grouping\n");
+                    continue;
+                }
+
+                GroupBy groups = {0};
+                if (groupWeatherTable(&groups, table, column - 1, table->temp, WEATHER_TEMP)) {
+                    printf("\nWeather Breakdown:\n");
+                    printGroupBy(&groups, "Temp");
+                }
+                freeGroupBy(&groups);
+
+            } else if (current_option == 8) {
+                // --- the k hottest, coldest, windiest and most humid hours in one pass ---
+                int k = 10;
+                printf("how many: ");
+                scanf("%d", &k);
+
+                TopK tops[EXTREME_KIND_COUNT];
+                if (findTopExtremes(table, k, tops)) {
+                    printTopExtremes(table, tops);
+                    for (int kind = 0; kind < EXTREME_KIND_COUNT; kind++) {
+                        freeTopK(&tops[kind]);
+                    }
+                }
+
+            } else if (current_option == 9) {
+                // --- 24h, 7d and 30d rolling windows, all in one pass ---
+                int step_hours = 24, last = 7;
+                printf("output every how many hours: ");
+                scanf("%d", &step_hours);
+                printf("show how many of the latest points: ");
+                scanf("%d", &last);
+
+                long widths[] = {24 * 3600L, 7 * 24 * 3600L, 30 * 24 * 3600L};
+                RollingSeries series;
+                if (rollingStatistics(table, widths, 3, (step_hours > 0 ? step_hours : 1) * 3600L, &series)) {
+                    printf("\nRolling Statistics (%d points):\n", series.count);
+                    printRollingSeries(&series, last);
+                    freeRollingSeries(&series);
+                }
+
             } else if (current_option == 0) {
                 printf("\n[ACTION] Exiting the program...\n");
                 // --- freeing memory ---
-                free(entries);
+                freeWeatherTable(table);
             }
 
         }
@@ -1,12 +1,27 @@
+#define _XOPEN_SOURCE 700
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <limits.h>
 #include <time.h>
 #include <stddef.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "weather_csv.h"
 
 #define MAGIC "WBIN"
 #define CITY_NAME_LEN 50
+#define WBIN_VERSION 2
+
+// --- v2 files are little-endian on every platform, so big-endian hosts swap each field ---
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define WBIN_SWAP 1
+#else
+#define WBIN_SWAP 0
+#endif
 
 // ---------------------------
 // ----- DATA STRUCTURES -----
@@ -18,38 +33,87 @@ typedef struct {
     int32_t record_count;     // Number of records
     char city[CITY_NAME_LEN]; // City Name
     float lat, lon;           // Geographical coordinates
-} FileHeader;
+} FileHeader;                 // version 1, followed by raw DataEntry records in the layout of the host
+
+typedef struct {
+    char magic[4];                // "WBIN", where FileHeader has it
+    float version;                // 2, where FileHeader has it
+    int64_t timestamp;            // file creation time
+    int64_t record_count;
+    int64_t record_offset;        // where the records start, a multiple of 8
+    int64_t dictionary_offset;    // where the string dictionary starts, a multiple of 8
+    int64_t dictionary_count;     // strings in the dictionary
+    int32_t lat, lon;             // millionths of a degree
+    char city[CITY_NAME_LEN];
+    char reserved[6];             // zeros, keeps the header a multiple of 8 bytes
+} WbinHeader;                     // version 2: little-endian, no padding, 112 bytes
+
+// --- after dictionary_offset: dictionary_count int64 offsets into the strings that follow them,
+//     each string ending with a '\0' ---
+// --- records stay row-oriented: reading a single field still pulls one cache line per record, so scans of a
+//     few fields gain less than the file shrinks ---
+typedef struct {
+    int64_t dt;                   // Unix timestamp, dt_iso is rebuilt from it
+    uint64_t city_name;           // ids in the string dictionary
+    uint64_t weather_main;
+    uint64_t weather_description;
+    uint64_t weather_icon;
+    int32_t lat;                  // millionths of a degree
+    int32_t lon;
+    int32_t timezone;             // seconds
+    int32_t visibility;           // meters
+    int16_t temp;                 // hundredths of a degree, exact for the two decimals of the exports
+    int16_t dew_point;
+    int16_t feels_like;
+    int16_t temp_min;
+    int16_t temp_max;
+    int16_t wind_speed;           // hundredths of m/s
+    int16_t wind_gust;
+    int16_t rain_1h;              // hundredths of mm
+    int16_t rain_3h;
+    int16_t snow_1h;
+    int16_t snow_3h;
+    int16_t pressure;             // hPa
+    int16_t sea_level;
+    int16_t grnd_level;
+    int16_t humidity;
+    int16_t wind_deg;
+    int16_t clouds_all;
+    int16_t weather_id;
+    int16_t reserved[2];          // zeros, keeps every field naturally aligned in an array of records
+} WbinRecord;                     // 96 bytes instead of the 480 of a DataEntry
+
+_Static_assert(sizeof(WbinHeader) == 112, "WbinHeader must not have padding");
+_Static_assert(sizeof(WbinRecord) == 96, "WbinRecord must not have padding");
+
+typedef struct {
+    char *strings;                // every distinct string, each ending with a '\0'
+    size_t size;
+    size_t capacity;
+    int64_t *offsets;             // where the string of every id starts
+    int64_t count;
+    int64_t *slots;               // open addressing hash table of ids, -1 for empty slots
+    int64_t slot_count;           // a power of two
+} WbinDictionary;
 
 typedef struct {
-    long dt;                        // Unix timestamp
-    char dt_iso[64];               // ISO formatted date and time
-    int timezone;                  // Timezone offset
-    char city_name[100];           // City name
-    double lat;                    // Latitude
-    double lon;                    // Longitude
-    double temp;                   // Temperature
-    int visibility;                // Visibility
-    double dew_point;              // Dew point
-    double feels_like;             // Feels like temperature
-    double temp_min;               // Minimum temperature
-    double temp_max;               // Maximum temperature
-    int pressure;                  // Atmospheric pressure
-    int sea_level;                 // Sea level pressure (could be 0 if not provided)
-    int grnd_level;                // Ground level pressure (could be 0 if not provided)
-    int humidity;                  // Humidity percentage
-    double wind_speed;             // Wind speed
-    int wind_deg;                  // Wind direction (degrees)
-    double wind_gust;              // Wind gust speed
-    double rain_1h;                // Rain in the last 1 hour
-    double rain_3h;                // Rain in the last 3 hours
-    double snow_1h;                // Snow in the last 1 hour
-    double snow_3h;                // Snow in the last 3 hours
-    int clouds_all;                // Cloud cover percentage
-    int weather_id;                // Weather condition ID
-    char weather_main[50];         // Main weather condition
-    char weather_description[100]; // Weather description
-    char weather_icon[10];         // Weather icon code
-} DataEntry;
+    void *map;                 // the whole file, mapped read-only
+    size_t size;
+    int version;               // 1 or 2
+    const DataEntry *records;  // version 1 records straight from the mapping, nothing is copied
+    const WbinRecord *packed;  // version 2 records straight from the mapping
+    const int64_t *string_offsets;
+    const char *strings;       // the string dictionary of a version 2 file
+    size_t strings_size;
+    int64_t string_count;
+    int count;
+    int *by_dt;                // record numbers sorted by dt, NULL when the file already is in dt order
+} BinaryView;
+
+typedef struct {
+    int first;  // position of the first match in dt order
+    int count;
+} RecordSpan;
 
 // ----------------------------
 // ----- PARSING FUNCTION -----
@@ -60,76 +124,311 @@ uint64_t parseDatetime(const char *datetime_str) {
     return (uint64_t) mktime(&tm);
 }
 
+// ---------------------------
+// ----- WBIN V2 RECORDS -----
+// ---------------------------
+uint16_t littleEndian16(uint16_t value) {
+    /*
+     * function for converting between host order and the little-endian order of v2 files (both ways)
+     * */
+    return WBIN_SWAP ? __builtin_bswap16(value) : value;
+}
+
+uint32_t littleEndian32(uint32_t value) {
+    return WBIN_SWAP ? __builtin_bswap32(value) : value;
+}
+
+uint64_t littleEndian64(uint64_t value) {
+    return WBIN_SWAP ? __builtin_bswap64(value) : value;
+}
+
+float littleEndianFloat(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    bits = littleEndian32(bits);
+    memcpy(&value, &bits, sizeof(bits));
+    return value;
+}
+
+void swapWbinRecord(WbinRecord *record) {
+    /*
+     * function for converting every field of a record between host and file order, nothing to do on little-endian hosts
+     * */
+    if (!WBIN_SWAP) {
+        return;
+    }
+    record->dt = (int64_t) littleEndian64((uint64_t) record->dt);
+    record->city_name = littleEndian64(record->city_name);
+    record->weather_main = littleEndian64(record->weather_main);
+    record->weather_description = littleEndian64(record->weather_description);
+    record->weather_icon = littleEndian64(record->weather_icon);
+
+    int32_t *words[] = {&record->lat, &record->lon, &record->timezone, &record->visibility};
+    for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+        *words[i] = (int32_t) littleEndian32((uint32_t) *words[i]);
+    }
+    // --- the int16 fields, from temp to the end of the record ---
+    for (int16_t *half = &record->temp; half < (int16_t *) (record + 1); half++) {
+        *half = (int16_t) littleEndian16((uint16_t) *half);
+    }
+}
+
+int16_t packInt16(double value, double scale) {
+    /*
+     * Function for storing a measurement as an int16 fixed point number
+     *  @param value: the measurement
+     *  @param scale: units per 1, e.g. 100 for hundredths
+     * @return: the rounded value, saturated to the int16 range (NaN becomes 0)
+     * */
+    double scaled = value * scale;
+    if (scaled != scaled) {
+        return 0;
+    }
+    if (scaled >= INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (scaled <= INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t) (scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+}
+
+int32_t packInt32(double value, double scale) {
+    /*
+     * same as packInt16, for the int32 fields
+     * */
+    double scaled = value * scale;
+    if (scaled != scaled) {
+        return 0;
+    }
+    if (scaled >= INT32_MAX) {
+        return INT32_MAX;
+    }
+    if (scaled <= INT32_MIN) {
+        return INT32_MIN;
+    }
+    return (int32_t) (scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+}
+
+int16_t clampInt16(int value) {
+    return (int16_t) (value > INT16_MAX ? INT16_MAX : value < INT16_MIN ? INT16_MIN : value);
+}
+
+int internWbinString(WbinDictionary *dict, const char *text, uint64_t *id) {
+    /*
+     * Function for finding the id of a string, adding it to the dictionary the first time it is seen
+     *  @param dict: pointer to the dictionary, zero initialized before the first call
+     *  @param text: the string
+     *  @param id: where to store its id
+     * @return: 1 if successful, 0 otherwise
+     * */
+    // --- FNV-1a hash of the string ---
+    size_t length = strlen(text);
+    uint64_t hash = 1469598103934665603ULL;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char) text[i]) * 1099511628211ULL;
+    }
+
+    // --- growing the hash table before it gets half full ---
+    if ((dict->count + 1) * 2 > dict->slot_count) {
+        int64_t slot_count = dict->slot_count ? dict->slot_count * 2 : 64;
+        int64_t *slots = malloc(slot_count * sizeof(int64_t));
+        int64_t *offsets = realloc(dict->offsets, slot_count / 2 * sizeof(int64_t));
+        if (!slots || !offsets) {
+            free(slots);
+            if (offsets) {
+                dict->offsets = offsets;
+            }
+            return 0;
+        }
+        dict->offsets = offsets;
+        memset(slots, -1, slot_count * sizeof(int64_t));
+        for (int64_t i = 0; i < dict->count; i++) {
+            const char *string = dict->strings + dict->offsets[i];
+            uint64_t rehash = 1469598103934665603ULL;
+            for (; *string; string++) {
+                rehash = (rehash ^ (unsigned char) *string) * 1099511628211ULL;
+            }
+            int64_t slot = (int64_t) (rehash & (uint64_t) (slot_count - 1));
+            while (slots[slot] >= 0) {
+                slot = (slot + 1) & (slot_count - 1);
+            }
+            slots[slot] = i;
+        }
+        free(dict->slots);
+        dict->slots = slots;
+        dict->slot_count = slot_count;
+    }
+
+    int64_t slot = (int64_t) (hash & (uint64_t) (dict->slot_count - 1));
+    while (dict->slots[slot] >= 0) {
+        if (strcmp(dict->strings + dict->offsets[dict->slots[slot]], text) == 0) {
+            *id = (uint64_t) dict->slots[slot];
+            return 1;
+        }
+        slot = (slot + 1) & (dict->slot_count - 1);
+    }
+
+    // --- a new string, appended to the string block ---
+    if (dict->size + length + 1 > dict->capacity) {
+        size_t capacity = dict->capacity ? dict->capacity : 4096;
+        while (capacity < dict->size + length + 1) {
+            capacity *= 2;
+        }
+        char *strings = realloc(dict->strings, capacity);
+        if (!strings) {
+            return 0;
+        }
+        dict->strings = strings;
+        dict->capacity = capacity;
+    }
+    memcpy(dict->strings + dict->size, text, length + 1);
+    dict->offsets[dict->count] = (int64_t) dict->size;
+    dict->size += length + 1;
+    dict->slots[slot] = dict->count;
+    *id = (uint64_t) dict->count++;
+    return 1;
+}
+
+void freeWbinDictionary(WbinDictionary *dict) {
+    free(dict->strings);
+    free(dict->offsets);
+    free(dict->slots);
+    memset(dict, 0, sizeof(WbinDictionary));
+}
+
+int encodeWbinRecord(const DataEntry *entry, WbinDictionary *dict, WbinRecord *record) {
+    /*
+     * Function for packing a parsed CSV row into a v2 record, in file order
+     *  @param entry: the parsed row
+     *  @param dict: string dictionary of the file
+     *  @param record: where to store the record
+     * @return: 1 if successful, 0 otherwise
+     * */
+    memset(record, 0, sizeof(WbinRecord));
+    if (!internWbinString(dict, entry->city_name, &record->city_name) ||
+        !internWbinString(dict, entry->weather_main, &record->weather_main) ||
+        !internWbinString(dict, entry->weather_description, &record->weather_description) ||
+        !internWbinString(dict, entry->weather_icon, &record->weather_icon)) {
+        return 0;
+    }
+
+    record->dt = entry->dt;
+    record->lat = packInt32(entry->lat, 1e6);
+    record->lon = packInt32(entry->lon, 1e6);
+    record->timezone = entry->timezone;
+    record->visibility = entry->visibility;
+    record->temp = packInt16(entry->temp, 100);
+    record->dew_point = packInt16(entry->dew_point, 100);
+    record->feels_like = packInt16(entry->feels_like, 100);
+    record->temp_min = packInt16(entry->temp_min, 100);
+    record->temp_max = packInt16(entry->temp_max, 100);
+    record->wind_speed = packInt16(entry->wind_speed, 100);
+    record->wind_gust = packInt16(entry->wind_gust, 100);
+    record->rain_1h = packInt16(entry->rain_1h, 100);
+    record->rain_3h = packInt16(entry->rain_3h, 100);
+    record->snow_1h = packInt16(entry->snow_1h, 100);
+    record->snow_3h = packInt16(entry->snow_3h, 100);
+    record->pressure = clampInt16(entry->pressure);
+    record->sea_level = clampInt16(entry->sea_level);
+    record->grnd_level = clampInt16(entry->grnd_level);
+    record->humidity = clampInt16(entry->humidity);
+    record->wind_deg = clampInt16(entry->wind_deg);
+    record->clouds_all = clampInt16(entry->clouds_all);
+    record->weather_id = clampInt16(entry->weather_id);
+
+    swapWbinRecord(record);
+    return 1;
+}
+
 // ---------------------------------
 // ----- BINARY FILE FUNCTIONS -----
 // ---------------------------------
 void convertCsv2Binary(const char *csv_path, const char *bin_path) {
+    /*
+     * Function for converting a CSV export to a WBIN v2 file: the header, the records, then the string dictionary
+     *  @param csv_path: path of the CSV file
+     *  @param bin_path: path of the binary file
+     * */
     FILE *CSV = fopen(csv_path, "r");
     FILE *BIN = fopen(bin_path, "wb");
 
     if (!CSV || !BIN) {
         perror("Error opening file");
+        if (CSV) fclose(CSV);
+        if (BIN) fclose(BIN);
         return;
     }
 
-    FileHeader header = {
+    WbinHeader header = {
             .magic = MAGIC,
-            .version = 1,
-            .timestamp = (uint64_t) time(NULL),
+            .version = WBIN_VERSION,
+            .timestamp = (int64_t) time(NULL),
             .record_count = 0,
-            .lat = 45.7558f,
-            .lon = 21.2322f
+            .record_offset = sizeof(WbinHeader),
+            .lat = 45755800,
+            .lon = 21232200
     };
     strcpy(header.city, "Timisoara");
 
-    fwrite(&header, sizeof(FileHeader), 1, BIN);
+    fwrite(&header, sizeof(WbinHeader), 1, BIN); // written again once the counts are known
 
+    WbinDictionary dict = {0};
+    int ok = 1;
     char line[1024];
     fgets(line, sizeof(line), CSV); // Skip header line
-    while (fgets(line, sizeof(line), CSV)) {
-        DataEntry entry;
-
-        sscanf(line,
-               "%ld,%63[^,],%d,%99[^,],%lf,%lf,%lf,%d,%lf,%lf,%lf,%lf,%d,%*[^,],%*[^,],%d,%lf,%d,%lf,%lf,%lf,%lf,%lf,%d,%d,%49[^,],%99[^,],%9[^\n]",
-               &entry.dt,
-               &entry.dt_iso,
-               &entry.timezone,
-               &entry.city_name,
-               &entry.lat,
-               &entry.lon,
-               &entry.temp,
-               &entry.visibility,
-               &entry.dew_point,
-               &entry.feels_like,
-               &entry.temp_min,
-               &entry.temp_max,
-               &entry.pressure,
-               &entry.humidity,
-               &entry.wind_speed,
-               &entry.wind_deg,
-               &entry.wind_gust,
-               &entry.rain_1h,
-               &entry.rain_3h,
-               &entry.snow_1h,
-               &entry.snow_3h,
-               &entry.clouds_all,
-               &entry.weather_id,
-               &entry.weather_main,
-               &entry.weather_description,
-               &entry.weather_icon);
-
-        fwrite(&entry, sizeof(DataEntry), 1, BIN);
+    while (ok && fgets(line, sizeof(line), CSV)) {
+        DataEntry entry = {0};
+        parseWeatherLine(line, &entry); // empty fields stay 0 instead of shifting the fields after them
+
+        // --- the header describes the city of the first row ---
+        if (header.record_count == 0 && entry.city_name[0]) {
+            snprintf(header.city, CITY_NAME_LEN, "%.*s", CITY_NAME_LEN - 1, entry.city_name);
+            header.lat = packInt32(entry.lat, 1e6);
+            header.lon = packInt32(entry.lon, 1e6);
+        }
+
+        WbinRecord record;
+        ok = encodeWbinRecord(&entry, &dict, &record) && fwrite(&record, sizeof(WbinRecord), 1, BIN) == 1;
 
         header.record_count++;
     }
 
+    // --- the dictionary follows the records, which end on a multiple of 8 since every record is 96 bytes ---
+    header.dictionary_offset = header.record_offset + header.record_count * (int64_t) sizeof(WbinRecord);
+    header.dictionary_count = dict.count;
+    for (int64_t i = 0; ok && i < dict.count; i++) {
+        int64_t offset = (int64_t) littleEndian64((uint64_t) dict.offsets[i]);
+        ok = fwrite(&offset, sizeof(offset), 1, BIN) == 1;
+    }
+    if (ok && dict.size) {
+        ok = fwrite(dict.strings, 1, dict.size, BIN) == dict.size;
+    }
+
+    int64_t record_count = header.record_count;
+    header.version = littleEndianFloat(header.version);
+    header.timestamp = (int64_t) littleEndian64((uint64_t) header.timestamp);
+    header.record_count = (int64_t) littleEndian64((uint64_t) header.record_count);
+    header.record_offset = (int64_t) littleEndian64((uint64_t) header.record_offset);
+    header.dictionary_offset = (int64_t) littleEndian64((uint64_t) header.dictionary_offset);
+    header.dictionary_count = (int64_t) littleEndian64((uint64_t) header.dictionary_count);
+    header.lat = (int32_t) littleEndian32((uint32_t) header.lat);
+    header.lon = (int32_t) littleEndian32((uint32_t) header.lon);
+
     fseek(BIN, 0, SEEK_SET); // Move to the beginning of the file
-    fwrite(&header, sizeof(FileHeader), 1, BIN); // Write the header again with updated record count
+    fwrite(&header, sizeof(WbinHeader), 1, BIN); // Write the header again with updated record count
 
+    freeWbinDictionary(&dict);
     fclose(CSV);
-    fclose(BIN);
+    if (fclose(BIN) != 0) {
+        ok = 0;
+    }
 
-    printf("Conversion complete. %d records written.\n", header.record_count);
+    if (!ok) {
+        printf("Error writing binary file\n");
+        return;
+    }
+    printf("Conversion complete. %lld records written.\n", (long long) record_count);
 
 }
 
@@ -142,7 +441,45 @@ void readFromBinary(const char *bin_path) {
 
     // ----- reading and displaying the file header -----
     FileHeader header;
-    fread(&header, sizeof(FileHeader), 1, binFile);
+    if (fread(&header, sizeof(FileHeader), 1, binFile) != 1) {
+        printf("Error reading header\n");
+        fclose(binFile);
+        return;
+    }
+
+    if (header.version != 1 && littleEndianFloat(header.version) == WBIN_VERSION) {
+        // ----- version 2: a little-endian header, fixed-width records -----
+        WbinHeader packed;
+        fseek(binFile, 0, SEEK_SET);
+        if (fread(&packed, sizeof(WbinHeader), 1, binFile) != 1) {
+            printf("Error reading header\n");
+            fclose(binFile);
+            return;
+        }
+
+        time_t created = (time_t) littleEndian64((uint64_t) packed.timestamp);
+        int64_t record_count = (int64_t) littleEndian64((uint64_t) packed.record_count);
+        printf("File Header:\n");
+        printf("Magic: %.4s\nVersion: %.1f\nCreated: %sRecords: %lld\nCity: %.*s (%.2f, %.2f)\n",
+               packed.magic, littleEndianFloat(packed.version), ctime(&created), (long long) record_count,
+               CITY_NAME_LEN, packed.city,
+               (int32_t) littleEndian32((uint32_t) packed.lat) / 1e6,
+               (int32_t) littleEndian32((uint32_t) packed.lon) / 1e6);
+
+        // ----- reading entries -----
+        WbinRecord *records = record_count > 0 && record_count <= INT_MAX
+                              ? malloc(record_count * sizeof(WbinRecord)) : NULL;
+        printf("\nWeather Records number: %lld\n", (long long) record_count);
+        if (records) {
+            fseek(binFile, (long) littleEndian64((uint64_t) packed.record_offset), SEEK_SET);
+            if (fread(records, sizeof(WbinRecord), record_count, binFile) != (size_t) record_count) {
+                printf("Error reading records\n");
+            }
+        }
+        free(records);
+        fclose(binFile);
+        return;
+    }
 
     printf("File Header:\n");
     printf("Magic: %s\nVersion: %.1f\nCreated: %sRecords: %d\nCity: %s (%.2f, %.2f)\n",
@@ -156,40 +493,349 @@ void readFromBinary(const char *bin_path) {
         fread(&entries[i], sizeof(DataEntry), 1, binFile);
     }
 
+    free(entries);
     fclose(binFile);
 }
 
 // -------------------------------
 // ----- OPERATIONS FUNCTION -----
 // -------------------------------
-void searchByDateRange(const char *bin_path, time_t start_date, time_t end_date) {
-    FILE *binFile = fopen(bin_path, "rb");
-    if (!binFile) {
-        perror("Error opening binary file");
+int compareRecordDates(const void *a, const void *b) {
+    /*
+     * function for ordering (dt, record) pairs by dt, keeping the file order on equal dates
+     * */
+    const long *x = a, *y = b;
+    if (x[0] != y[0]) {
+        return x[0] < y[0] ? -1 : 1;
+    }
+    return (x[1] > y[1]) - (x[1] < y[1]);
+}
+
+void closeBinaryView(BinaryView *view) {
+    /*
+     * function for unmapping a binary file
+     * */
+    if (view->map) {
+        munmap(view->map, view->size);
+    }
+    free(view->by_dt);
+    memset(view, 0, sizeof(BinaryView));
+}
+
+long recordDate(const BinaryView *view, int record) {
+    /*
+     * function for reading the dt of a record, whatever the version of the file
+     * */
+    if (view->version == 1) {
+        return view->records[record].dt;
+    }
+    return (long) (int64_t) littleEndian64((uint64_t) view->packed[record].dt);
+}
+
+void formatUtcDate(int64_t dt, char *buffer, size_t size) {
+    /*
+     * Function for writing a timestamp the way the exports write dt_iso, "YYYY-MM-DD HH:MM:SS +0000 UTC"
+     *  @param dt: Unix timestamp
+     *  @param buffer: where to write it
+     *  @param size: size of buffer
+     * */
+    // --- civilTime and a few digit writes instead of gmtime_r and strftime, which cost more than the rest of
+    //     a scan together ---
+    CivilTime civil;
+    civilTime(dt, &civil);
+
+    if (civil.year < 1000 || civil.year > 9999 || size < 31) {
+        snprintf(buffer, size, "%lld-%02d-%02d %02d:%02d:%02d +0000 UTC", (long long) civil.year, civil.month,
+                 civil.day, civil.hour, civil.minute, civil.second);
         return;
     }
+    int fields[] = {(int) (civil.year / 100), (int) (civil.year % 100), civil.month, civil.day,
+                    civil.hour, civil.minute, civil.second};
+    memcpy(buffer, "0000-00-00 00:00:00 +0000 UTC", 30);
+    const int at[] = {0, 2, 5, 8, 11, 14, 17};
+    for (int i = 0; i < 7; i++) {
+        buffer[at[i]] = (char) ('0' + fields[i] / 10);
+        buffer[at[i] + 1] = (char) ('0' + fields[i] % 10);
+    }
+}
 
-    FileHeader header;
-    fread(&header, sizeof(FileHeader), 1, binFile);
+double recordTemperature(const BinaryView *view, int record) {
+    /*
+     * function for reading the temperature of a record without decoding the rest of it
+     * */
+    if (view->version == 1) {
+        return view->records[record].temp;
+    }
+    return (int16_t) littleEndian16((uint16_t) view->packed[record].temp) / 100.0;
+}
 
-//    printf("Searching for records between %s", ctime(&start_date));
-//    printf("and %s\n", ctime(&end_date));
+const char *recordDateIso(const BinaryView *view, int record, char *buffer, size_t size) {
+    /*
+     * Function for reading the dt_iso of a record without decoding the rest of it
+     *  @param view: pointer to the view
+     *  @param record: record number
+     *  @param buffer: where version 2 files rebuild it from dt
+     *  @param size: size of buffer
+     * @return: the dt_iso, inside the mapping for version 1 files and in buffer for version 2
+     * */
+    if (view->version == 1) {
+        return view->records[record].dt_iso;
+    }
+    formatUtcDate(recordDate(view, record), buffer, size);
+    return buffer;
+}
 
-    int found_count = 0;
-    DataEntry entry;
+const char *wbinString(const BinaryView *view, uint64_t id) {
+    /*
+     * function for looking up a string of the dictionary, "" for ids or offsets outside of it
+     * */
+    if (id >= (uint64_t) view->string_count) {
+        return "";
+    }
+    uint64_t offset = littleEndian64((uint64_t) view->string_offsets[id]);
+    return offset < view->strings_size ? view->strings + offset : "";
+}
 
-    for (int i = 0; i < header.record_count; i++) {
-        fread(&entry, sizeof(DataEntry), 1, binFile);
+void copyWbinString(const BinaryView *view, uint64_t id, char *text, size_t size) {
+    /*
+     * function for copying a string of the dictionary into a DataEntry field, cut to fit like snprintf would
+     * */
+    const char *string = wbinString(view, id);
+    size_t length = strnlen(string, size - 1);
+    memcpy(text, string, length);
+    text[length] = '\0';
+}
+
+void readRecord(const BinaryView *view, int record, DataEntry *entry) {
+    /*
+     * Function for reading a record as a DataEntry, whatever the version of the file
+     *  @param view: pointer to the view
+     *  @param record: record number
+     *  @param entry: where to store it, dt_iso is rebuilt from dt for version 2 files
+     * */
+    if (view->version == 1) {
+        *entry = view->records[record];
+        return;
+    }
+
+    WbinRecord packed = view->packed[record];
+    swapWbinRecord(&packed);
+
+    memset(entry, 0, sizeof(DataEntry));
+    entry->dt = (long) packed.dt;
+    formatUtcDate(packed.dt, entry->dt_iso, sizeof(entry->dt_iso));
+    entry->timezone = packed.timezone;
+    copyWbinString(view, packed.city_name, entry->city_name, sizeof(entry->city_name));
+    entry->lat = packed.lat / 1e6;
+    entry->lon = packed.lon / 1e6;
+    entry->temp = packed.temp / 100.0;
+    entry->visibility = packed.visibility;
+    entry->dew_point = packed.dew_point / 100.0;
+    entry->feels_like = packed.feels_like / 100.0;
+    entry->temp_min = packed.temp_min / 100.0;
+    entry->temp_max = packed.temp_max / 100.0;
+    entry->pressure = packed.pressure;
+    entry->sea_level = packed.sea_level;
+    entry->grnd_level = packed.grnd_level;
+    entry->humidity = packed.humidity;
+    entry->wind_speed = packed.wind_speed / 100.0;
+    entry->wind_deg = packed.wind_deg;
+    entry->wind_gust = packed.wind_gust / 100.0;
+    entry->rain_1h = packed.rain_1h / 100.0;
+    entry->rain_3h = packed.rain_3h / 100.0;
+    entry->snow_1h = packed.snow_1h / 100.0;
+    entry->snow_3h = packed.snow_3h / 100.0;
+    entry->clouds_all = packed.clouds_all;
+    entry->weather_id = packed.weather_id;
+    copyWbinString(view, packed.weather_main, entry->weather_main, sizeof(entry->weather_main));
+    copyWbinString(view, packed.weather_description, entry->weather_description, sizeof(entry->weather_description));
+    copyWbinString(view, packed.weather_icon, entry->weather_icon, sizeof(entry->weather_icon));
+}
+
+int mapWbinSections(BinaryView *view) {
+    /*
+     * Function for checking the layout of a version 2 file and pointing the view at its records and dictionary
+     *  @param view: view with the file mapped
+     * @return: 1 if every section lies inside the file, 0 otherwise
+     * */
+    if (view->size < sizeof(WbinHeader)) {
+        return 0;
+    }
+    const WbinHeader *header = view->map;
+    uint64_t record_count = littleEndian64((uint64_t) header->record_count);
+    uint64_t record_offset = littleEndian64((uint64_t) header->record_offset);
+    uint64_t dictionary_offset = littleEndian64((uint64_t) header->dictionary_offset);
+    uint64_t dictionary_count = littleEndian64((uint64_t) header->dictionary_count);
+
+    // --- every section aligned, in order and inside the file; the comparisons are arranged not to overflow ---
+    if (record_count > INT_MAX || record_offset % 8 != 0 || dictionary_offset % 8 != 0 ||
+        record_offset < sizeof(WbinHeader) || record_offset > view->size ||
+        record_count > (view->size - record_offset) / sizeof(WbinRecord) ||
+        dictionary_offset < record_offset + record_count * sizeof(WbinRecord) || dictionary_offset > view->size ||
+        dictionary_count > (view->size - dictionary_offset) / sizeof(int64_t)) {
+        return 0;
+    }
+
+    view->packed = (const WbinRecord *) ((const char *) view->map + record_offset);
+    view->count = (int) record_count;
+    view->string_offsets = (const int64_t *) ((const char *) view->map + dictionary_offset);
+    view->string_count = (int64_t) dictionary_count;
+    view->strings = (const char *) (view->string_offsets + dictionary_count);
+    view->strings_size = view->size - (dictionary_offset + dictionary_count * sizeof(int64_t));
+
+    // --- the last string must end inside the file ---
+    return dictionary_count == 0 || (view->strings_size > 0 && view->strings[view->strings_size - 1] == '\0');
+}
+
+int openBinaryView(const char *bin_path, BinaryView *view) {
+    /*
+     * Function for mapping a binary file and preparing it for date range queries
+     *  @param bin_path: path of the binary file, version 1 or 2
+     *  @param view: where to store the view, released with closeBinaryView
+     * @return: 1 if successful, 0 otherwise
+     * */
+    memset(view, 0, sizeof(BinaryView));
+    int fd = open(bin_path, O_RDONLY);
+    if (fd < 0) {
+        perror("Error opening binary file");
+        return 0;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(FileHeader)) {
+        printf("Error reading header\n");
+        close(fd);
+        return 0;
+    }
+    view->size = (size_t) info.st_size;
+    view->map = mmap(NULL, view->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view->map == MAP_FAILED) {
+        perror("Error mapping binary file");
+        view->map = NULL;
+        return 0;
+    }
 
-        if (entry.dt >= start_date && entry.dt <= end_date) {
-            found_count++;
-            printf("Record #%d - Date: %s, Temp: %.1f°C\n",
-                   i+1, entry.dt_iso, entry.temp);
+    const FileHeader *header = view->map;
+    if (strncmp(header->magic, MAGIC, 4) != 0) {
+        printf("Invalid file format - magic number mismatch\n");
+        closeBinaryView(view);
+        return 0;
+    }
+
+    if (header->version == 1) {
+        view->version = 1;
+        view->records = (const DataEntry *) ((const char *) view->map + sizeof(FileHeader));
+        view->count = header->record_count;
+        if (view->count < 0 || (size_t) view->count > (view->size - sizeof(FileHeader)) / sizeof(DataEntry)) {
+            printf("Invalid record count: %d\n", view->count);
+            closeBinaryView(view);
+            return 0;
+        }
+    } else if (littleEndianFloat(header->version) == WBIN_VERSION) {
+        view->version = 2;
+        if (!mapWbinSections(view)) {
+            printf("Invalid file layout\n");
+            closeBinaryView(view);
+            return 0;
         }
+    } else {
+        printf("Unsupported version: %.1f\n", header->version);
+        closeBinaryView(view);
+        return 0;
     }
 
-    printf("\nTotal records found: %d\n", found_count);
-    fclose(binFile);
+    // --- records are written in CSV order, which is time order for weather exports; only otherwise
+    //     a sorted list of record numbers is needed ---
+    int sorted = 1;
+    for (int i = 1; i < view->count && sorted; i++) {
+        sorted = recordDate(view, i - 1) <= recordDate(view, i);
+    }
+    if (!sorted) {
+        long (*pairs)[2] = malloc(view->count * sizeof(*pairs));
+        view->by_dt = malloc(view->count * sizeof(int));
+        if (!pairs || !view->by_dt) {
+            free(pairs);
+            closeBinaryView(view);
+            return 0;
+        }
+        for (int i = 0; i < view->count; i++) {
+            pairs[i][0] = recordDate(view, i);
+            pairs[i][1] = i;
+        }
+        qsort(pairs, view->count, sizeof(*pairs), compareRecordDates);
+        for (int i = 0; i < view->count; i++) {
+            view->by_dt[i] = (int) pairs[i][1];
+        }
+        free(pairs);
+    }
+
+    return 1;
+}
+
+int recordInDateOrder(const BinaryView *view, int position) {
+    /*
+     * function for finding the record number at a position of the dt order
+     * */
+    return view->by_dt ? view->by_dt[position] : position;
+}
+
+int firstRecordAfter(const BinaryView *view, time_t timestamp, int inclusive) {
+    /*
+     * Function for binary searching the records by date
+     *  @param view: pointer to the view
+     *  @param timestamp: date to look for
+     *  @param inclusive: 1 to find the first record with dt >= timestamp, 0 for dt > timestamp
+     * @return: position of that record in dt order (count if there is none)
+     * */
+    int low = 0, high = view->count;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        long dt = recordDate(view, recordInDateOrder(view, middle));
+        if (dt < timestamp || (!inclusive && dt == timestamp)) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+RecordSpan findDateRange(const BinaryView *view, time_t start_date, time_t end_date) {
+    /*
+     * Function for finding the records of a date range in O(log n)
+     *  @param view: pointer to the view
+     *  @param start_date: first date of the range
+     *  @param end_date: last date of the range, included
+     * @return: the matches as a span of the dt order, see recordInDateOrder
+     * */
+    RecordSpan span;
+    span.first = firstRecordAfter(view, start_date, 1);
+    int last = firstRecordAfter(view, end_date, 0);
+    span.count = last > span.first ? last - span.first : 0;
+    return span;
+}
+
+void searchByDateRange(const char *bin_path, time_t start_date, time_t end_date) {
+    BinaryView view;
+    if (!openBinaryView(bin_path, &view)) {
+        return;
+    }
+
+//    printf("Searching for records between %s", ctime(&start_date));
+//    printf("and %s\n", ctime(&end_date));
+
+    // --- only the two printed columns are read, no record is decoded as a whole ---
+    RecordSpan span = findDateRange(&view, start_date, end_date);
+    for (int i = 0; i < span.count; i++) {
+        int record = recordInDateOrder(&view, span.first + i);
+        char date[64];
+        printf("Record #%d - Date: %s, Temp: %.1f°C\n",
+               record + 1, recordDateIso(&view, record, date, sizeof(date)), recordTemperature(&view, record));
+    }
+
+    printf("\nTotal records found: %d\n", span.count);
+    closeBinaryView(&view);
 }
 
 int verifyFileIntegrity(const char *bin_path) {
@@ -214,6 +860,30 @@ int verifyFileIntegrity(const char *bin_path) {
         return 0;
     }
 
+    // ----- version 2: the view checks the sections, every dictionary id is checked here -----
+    if (header.version != 1 && littleEndianFloat(header.version) == WBIN_VERSION) {
+        fclose(binFile);
+        BinaryView view;
+        if (!openBinaryView(bin_path, &view)) {
+            return 0;
+        }
+        for (int i = 0; i < view.count; i++) {
+            const WbinRecord *record = &view.packed[i];
+            if (littleEndian64(record->city_name) >= (uint64_t) view.string_count ||
+                littleEndian64(record->weather_main) >= (uint64_t) view.string_count ||
+                littleEndian64(record->weather_description) >= (uint64_t) view.string_count ||
+                littleEndian64(record->weather_icon) >= (uint64_t) view.string_count) {
+                printf("Invalid string id in record #%d\n", i + 1);
+                closeBinaryView(&view);
+                return 0;
+            }
+        }
+        printf("File integrity verified. Format: %.4s, Version: %.1f, Records: %d, Strings: %lld\n",
+               header.magic, (double) WBIN_VERSION, view.count, (long long) view.string_count);
+        closeBinaryView(&view);
+        return 1;
+    }
+
     // ----- verify record count -----
     fseek(binFile, 0, SEEK_END);
     long fileSize = ftell(binFile);
@@ -0,0 +1,326 @@
+#ifndef WEATHER_CSV_H
+#define WEATHER_CSV_H
+
+#include <stdint.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+// -------------------------------------
+// ----- SHARED WEATHER CSV PARSER -----
+// -------------------------------------
+// Used by lab3.c and lab4.c. A line is walked once, field after field, without allocating;
+// an empty field is reported as a null instead of shifting the fields after it.
+
+typedef struct {
+    long dt;                        // Unix timestamp
+    char dt_iso[64];               // ISO formatted date and time
+    int timezone;                  // Timezone offset
+    char city_name[100];           // City name
+    double lat;                    // Latitude
+    double lon;                    // Longitude
+    double temp;                   // Temperature
+    int visibility;                // Visibility
+    double dew_point;              // Dew point
+    double feels_like;             // Feels like temperature
+    double temp_min;               // Minimum temperature
+    double temp_max;               // Maximum temperature
+    int pressure;                  // Atmospheric pressure
+    int sea_level;                 // Sea level pressure (could be 0 if not provided)
+    int grnd_level;                // Ground level pressure (could be 0 if not provided)
+    int humidity;                  // Humidity percentage
+    double wind_speed;             // Wind speed
+    int wind_deg;                  // Wind direction (degrees)
+    double wind_gust;              // Wind gust speed
+    double rain_1h;                // Rain in the last 1 hour
+    double rain_3h;                // Rain in the last 3 hours
+    double snow_1h;                // Snow in the last 1 hour
+    double snow_3h;                // Snow in the last 3 hours
+    int clouds_all;                // Cloud cover percentage
+    int weather_id;                // Weather condition ID
+    char weather_main[50];         // Main weather condition
+    char weather_description[100]; // Weather description
+    char weather_icon[10];         // Weather icon code
+} DataEntry;
+
+// ----- column order of the CSV, also the bit of every field in a null mask -----
+typedef enum {
+    WEATHER_DT, WEATHER_DT_ISO, WEATHER_TIMEZONE, WEATHER_CITY_NAME, WEATHER_LAT, WEATHER_LON, WEATHER_TEMP,
+    WEATHER_VISIBILITY, WEATHER_DEW_POINT, WEATHER_FEELS_LIKE, WEATHER_TEMP_MIN, WEATHER_TEMP_MAX,
+    WEATHER_PRESSURE, WEATHER_SEA_LEVEL, WEATHER_GRND_LEVEL, WEATHER_HUMIDITY, WEATHER_WIND_SPEED,
+    WEATHER_WIND_DEG, WEATHER_WIND_GUST, WEATHER_RAIN_1H, WEATHER_RAIN_3H, WEATHER_SNOW_1H, WEATHER_SNOW_3H,
+    WEATHER_CLOUDS_ALL, WEATHER_WEATHER_ID, WEATHER_WEATHER_MAIN, WEATHER_WEATHER_DESCRIPTION,
+    WEATHER_WEATHER_ICON, WEATHER_FIELD_COUNT
+} WeatherField;
+
+static inline int csvAtEnd(char c) {
+    /*
+     * function for checking if a character ends a field
+     * */
+    // --- a table lookup instead of four comparisons, since this runs for every character ---
+    static const unsigned char ends[256] = {[','] = 1, ['\n'] = 1, ['\r'] = 1, ['\0'] = 1};
+    return ends[(unsigned char) c];
+}
+
+static inline void csvSkipField(const char **cursor) {
+    /*
+     * Function for moving the cursor past the current field and its comma
+     *  @param cursor: position in the line, anywhere inside a field
+     * */
+    const char *p = *cursor;
+    while (!csvAtEnd(*p)) {
+        p++;
+    }
+    *cursor = p + (*p == ',');
+}
+
+static inline int csvNextLong(const char **cursor, long *value) {
+    /*
+     * Function for parsing an integer field and moving to the next field
+     *  @param cursor: position in the line, at the start of a field
+     *  @param value: where to store the number, 0 for a null
+     * @return: 1 if the field held a number, 0 if it was empty (or not a number, or out of the range of a long)
+     * */
+    const char *p = *cursor;
+    int negative = *p == '-';
+    if (*p == '-' || *p == '+') {
+        p++;
+    }
+
+    // --- at most 19 digits are accumulated, which always fits in 64 unsigned bits; longer runs are not numbers ---
+    unsigned long long number = 0;
+    const char *digits = p;
+    while ((unsigned) (*p - '0') < 10) {
+        if (p - digits < 19) {
+            number = number * 10 + (unsigned) (*p - '0');
+        }
+        p++;
+    }
+
+    int present = p > digits && p - digits <= 19 && csvAtEnd(*p) &&
+                  number <= (negative ? (unsigned long long) LONG_MAX + 1 : (unsigned long long) LONG_MAX);
+    *value = !present ? 0 : negative ? (long) (0 - number) : (long) number;
+    csvSkipField(&p);
+    *cursor = p;
+    return present;
+}
+
+static inline int csvNextInt(const char **cursor, int *value) {
+    /*
+     * function for parsing an int field, see csvNextLong; a number out of the range of an int is a null
+     * */
+    long number;
+    int present = csvNextLong(cursor, &number) && number >= INT_MIN && number <= INT_MAX;
+    *value = present ? (int) number : 0;
+    return present;
+}
+
+static inline int csvNextDouble(const char **cursor, double *value) {
+    /*
+     * Function for parsing a decimal field and moving to the next field
+     *  @param cursor: position in the line, at the start of a field
+     *  @param value: where to store the number, 0 for a null
+     * @return: 1 if the field held a number, 0 if it was empty (or not a number)
+     * */
+    static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    const char *start = *cursor, *p = start;
+    int negative = *p == '-';
+    if (*p == '-' || *p == '+') {
+        p++;
+    }
+
+    // --- gathering every digit into one integer, remembering where the point was ---
+    uint64_t mantissa = 0;
+    int digits = 0, scale = 0;
+    for (; (unsigned) (*p - '0') < 10; p++, digits++) {
+        mantissa = mantissa * 10 + (uint64_t) (*p - '0');
+    }
+    if (*p == '.') {
+        for (p++; (unsigned) (*p - '0') < 10; p++, digits++, scale--) {
+            mantissa = mantissa * 10 + (uint64_t) (*p - '0');
+        }
+    }
+    int valid = digits > 0;
+    if (valid && (*p == 'e' || *p == 'E')) {
+        long exponent;
+        const char *e = p + 1;
+        valid = csvNextLong(&e, &exponent);
+        scale += exponent > 9999 ? 9999 : exponent < -9999 ? -9999 : (int) exponent; // strtod takes it from there
+        while (!csvAtEnd(*p)) {
+            p++;
+        }
+    }
+
+    int present = valid && csvAtEnd(*p);
+    if (!present) {
+        *value = 0;
+    } else if (digits <= 15 && scale >= -22 && scale <= 22) {
+        // --- both operands are exact, so a single multiplication or division rounds like strtod ---
+        double number = scale < 0 ? (double) mantissa / powers[-scale] : (double) mantissa * powers[scale];
+        *value = negative ? -number : number;
+    } else {
+        *value = strtod(start, NULL);
+    }
+
+    csvSkipField(&p);
+    *cursor = p;
+    return present;
+}
+
+static inline int csvNextSlice(const char **cursor, const char **text, size_t *length) {
+    /*
+     * Function for finding a text field where it lies in the line, without copying it, and moving to the next field
+     *  @param cursor: position in the line, at the start of a field
+     *  @param text: where to store the start of the text (inside the quotes of a quoted field, "" is kept as is)
+     *  @param length: where to store the length of the text
+     * @return: 1 if the field had any text, 0 if it was empty
+     * */
+    const char *p = *cursor;
+
+    if (*p == '"') {
+        for (*text = ++p; *p != '\0' && !(*p == '"' && p[1] != '"'); p += *p == '"' ? 2 : 1) {
+        }
+        *length = (size_t) (p - *text);
+        if (*p == '"') {
+            p++;
+        }
+    } else {
+        for (*text = p; !csvAtEnd(*p); p++) {
+        }
+        *length = (size_t) (p - *text);
+    }
+
+    csvSkipField(&p);
+    *cursor = p;
+    return *length > 0;
+}
+
+static inline int csvNextString(const char **cursor, char *value, size_t size) {
+    /*
+     * Function for copying a text field (quotes removed) and moving to the next field
+     *  @param cursor: position in the line, at the start of a field
+     *  @param value: where to store the text, cut to size - 1 characters
+     *  @param size: size of value
+     * @return: 1 if the field had any text, 0 if it was empty
+     * */
+    const char *p = *cursor;
+    size_t length = 0;
+
+    if (*p == '"') {
+        // --- a quoted field may hold commas; "" stands for one quote ---
+        for (p++; *p != '\0' && !(*p == '"' && p[1] != '"'); p++) {
+            if (*p == '"') {
+                p++;
+            }
+            if (length + 1 < size) {
+                value[length++] = *p;
+            }
+        }
+        if (*p == '"') {
+            p++;
+        }
+    } else {
+        const char *start = p;
+        while (!csvAtEnd(*p)) {
+            p++;
+        }
+        length = (size_t) (p - start) < size - 1 ? (size_t) (p - start) : size - 1;
+        memcpy(value, start, length);
+    }
+    value[length] = '\0';
+
+    csvSkipField(&p);
+    *cursor = p;
+    return length > 0;
+}
+
+static inline unsigned int parseWeatherLine(const char *line, DataEntry *entry) {
+    /*
+     * Function for parsing one line of the weather CSV into a record
+     *  @param line: the line, with or without its line break
+     *  @param entry: where to store the record; null fields are set to 0 (or "")
+     * @return: null mask, with bit WeatherField set for every empty field (and every number that does not fit)
+     * */
+    const char *p = line;
+    unsigned int nulls = 0;
+
+    nulls |= (unsigned) !csvNextLong(&p, &entry->dt) << WEATHER_DT;
+    nulls |= (unsigned) !csvNextString(&p, entry->dt_iso, sizeof(entry->dt_iso)) << WEATHER_DT_ISO;
+    nulls |= (unsigned) !csvNextInt(&p, &entry->timezone) << WEATHER_TIMEZONE;
+    nulls |= (unsigned) !csvNextString(&p, entry->city_name, sizeof(entry->city_name)) << WEATHER_CITY_NAME;
+    nulls |= (unsigned) !csvNextDouble(&p, &entry->lat) << WEATHER_LAT;
+    nulls |= (unsigned) !csvNextDouble(&p, &entry->lon) << WEATHER_LON;
+    nulls |= (unsigned) !csvNextDouble(&p, &entry->temp) << WEATHER_TEMP;
+    nulls |= (unsigned) !csvNextInt(&p, &entry->visibility) << WEATHER_VISIBILITY;
+    nulls |= (unsigned) !csvNextDouble(&p, &entry->dew_point) << WEATHER_DEW_POINT;
+    nulls |= (unsigned) !csvNextDouble(&p, &entry->feels_like) << WEATHER_FEELS_LIKE;
+    nulls |= (unsigned) !csvNextDouble(&p, &entry->temp_min) << WEATHER_TEMP_MIN;
+    nulls |= (unsigned) !csvNextDouble(&p, &entry->temp_max) << WEATHER_TEMP_MAX;
+    nulls |= (unsigned) !csvNextInt(&p, &entry->pressure) << WEATHER_PRESSURE;
+    nulls |= (unsigned) !csvNextInt(&p, &entry->sea_level) << WEATHER_SEA_LEVEL;
+    nulls |= (unsigned) !csvNextInt(&p, &entry->grnd_level) << WEATHER_GRND_LEVEL;
+    nulls |= (unsigned) !csvNextInt(&p, &entry->humidity) << WEATHER_HUMIDITY;
+    nulls |= (unsigned) !csvNextDouble(&p, &entry->wind_speed) << WEATHER_WIND_SPEED;
+    nulls |= (unsigned) !csvNextInt(&p, &entry->wind_deg) << WEATHER_WIND_DEG;
+    nulls |= (unsigned) !csvNextDouble(&p, &entry->wind_gust) << WEATHER_WIND_GUST;
+    nulls |= (unsigned) !csvNextDouble(&p, &entry->rain_1h) << WEATHER_RAIN_1H;
+    nulls |= (unsigned) !csvNextDouble(&p, &entry->rain_3h) << WEATHER_RAIN_3H;
+    nulls |= (unsigned) !csvNextDouble(&p, &entry->snow_1h) << WEATHER_SNOW_1H;
+    nulls |= (unsigned) !csvNextDouble(&p, &entry->snow_3h) << WEATHER_SNOW_3H;
+    nulls |= (unsigned) !csvNextInt(&p, &entry->clouds_all) << WEATHER_CLOUDS_ALL;
+    nulls |= (unsigned) !csvNextInt(&p, &entry->weather_id) << WEATHER_WEATHER_ID;
+    nulls |= (unsigned) !csvNextString(&p, entry->weather_main, sizeof(entry->weather_main)) << WEATHER_WEATHER_MAIN;
+    nulls |= (unsigned) !csvNextString(&p, entry->weather_description, sizeof(entry->weather_description))
+            << WEATHER_WEATHER_DESCRIPTION;
+    nulls |= (unsigned) !csvNextString(&p, entry->weather_icon, sizeof(entry->weather_icon)) << WEATHER_WEATHER_ICON;
+
+    return nulls;
+}
+
+// --------------------------
+// ----- CALENDAR DATES -----
+// --------------------------
+typedef struct {
+    int64_t year;
+    int month;        // 1-12
+    int day;          // 1-31
+    int day_of_year;  // 1-366
+    int hour;         // 0-23
+    int minute;
+    int second;
+} CivilTime;
+
+static inline void civilTime(int64_t seconds, CivilTime *civil) {
+    /*
+     * Function for splitting a Unix time into UTC calendar fields with integer arithmetic only (no gmtime_r),
+     * shared by the lab3 calendar buckets and the lab4 dt_iso rebuild
+     *  @param seconds: seconds since 1970-01-01 00:00, shifted by a timezone beforehand for local time
+     *  @param civil: where to store the fields
+     * */
+    int64_t days = seconds / 86400, second_of_day = seconds % 86400;
+    if (second_of_day < 0) {
+        days--;
+        second_of_day += 86400;
+    }
+    civil->hour = (int) (second_of_day / 3600);
+    civil->minute = (int) (second_of_day / 60 % 60);
+    civil->second = (int) (second_of_day % 60);
+
+    // --- days to a civil date, counting years from March so the leap day is the last day of a year ---
+    int64_t z = days + 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    int64_t day_of_era = z - era * 146097;
+    int64_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    int64_t day_from_march = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    int64_t month_from_march = (5 * day_from_march + 2) / 153;
+
+    civil->day = (int) (day_from_march - (153 * month_from_march + 2) / 5 + 1);
+    civil->month = (int) (month_from_march < 10 ? month_from_march + 3 : month_from_march - 9);
+    civil->year = year_of_era + era * 400 + (civil->month <= 2);
+
+    int leap = (civil->year % 4 == 0 && civil->year % 100 != 0) || civil->year % 400 == 0;
+    civil->day_of_year = (int) (civil->month <= 2 ? day_from_march - 305 : day_from_march + 60 + leap);
+}
+
+#endif
@@ -1,7 +1,54 @@
+#define _GNU_SOURCE
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include <time.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
 
-#define MAX_SIZE 1000
+// ----- accessing a cell of a heap-allocated maze -----
+#define MAZE_CELL(maze, row, col) ((maze)->grid[(size_t)(row) * (maze)->stride + (col)])
+
+// ----- bit index of a cell in the bitmaps, which surround the grid with a one-cell wall border -----
+#define MAZE_BIT(maze, row, col) ((uint32_t)(((size_t)(row) + 1) * (maze)->bit_stride + (col) + 1))
+
+// ----- bitmap and packed direction helpers -----
+#define BIT_TEST(bits, i) (((bits)[(i) >> 6] >> ((i) & 63)) & 1)
+#define BIT_SET(bits, i) ((bits)[(i) >> 6] |= (uint64_t) 1 << ((i) & 63))
+#define DIR_GET(dirs, i) (((dirs)[(i) >> 2] >> (((i) & 3) * 2)) & 3)
+
+// ----- k-th queue entry of one side of the bidirectional search -----
+#define SIDE_AT(side, k) ((side)->queue[(long) (k) * (side)->step])
+
+#define DIST_MAGIC "MDST"
+#define PATH_MAGIC "MPTH"
+
+// ----- side of a room (wall included) in the generated benchmark mazes -----
+#define BENCH_ROOM_SIZE 32
+
+// ----- longest run of a path file; a run packs its direction in the top two bits -----
+#define PATH_RUN_MAX 0x3fffffffu
+
+// ----- highest terrain cost of a weighted cell ('1' to '9'); every other open cell costs 1 -----
+#define WEIGHT_MAX 9
+
+// ----- streaming reachability: cells of a band when no row count is given, and the parent of a wall -----
+#define REACH_BAND_CELLS (1 << 20)
+#define REACH_WALL UINT32_MAX
+
+// ----- parallel BFS tuning: cells handed out at a time, and the level size worth waking the pool for -----
+#define PARALLEL_BFS_CHUNK 256
+#define PARALLEL_BFS_MIN_FRONTIER 4096
 
 
 // ----------------------------------
@@ -10,15 +57,208 @@
 
 // ----- defining the maze structure -----
 typedef struct {
-    char grid[MAX_SIZE][MAX_SIZE];
+    char *grid;    // rows * stride bytes, row-major, every row terminated by '\n'
+    size_t stride; // bytes from the start of one row to the next (cols + 1)
     int rows;
     int cols;
     int start_row;
     int start_col;
     int end_row;
     int end_col;
+    uint64_t *walls;    // one bit per cell of the padded grid, set for walls and the border
+    size_t bit_stride;  // bits from the start of one padded row to the next (a multiple of 64)
+    size_t mapped_size; // length of the file mapping the grid lives in, 0 if the grid is malloc'd
+    dev_t mapped_dev;   // device and inode of that file, so writing over it can be detected
+    ino_t mapped_ino;
+    uint8_t *costs;     // cost of entering every cell of the padded grid, NULL if the maze has no terrain digits
 } Maze;
 
+// ----- available solving strategies -----
+typedef enum {
+    SOLVER_BACKTRACK,     // depth-first, first path found (not necessarily the shortest)
+    SOLVER_BFS,           // breadth-first, shortest path
+    SOLVER_ASTAR,         // A* with the Manhattan heuristic, shortest path
+    SOLVER_PARALLEL,      // level-synchronous BFS on several threads, same path as SOLVER_BFS
+    SOLVER_BIDIRECTIONAL, // BFS from both ends meeting in the middle, shortest path
+    SOLVER_WEIGHTED,      // Dijkstra on the terrain costs with a bucket queue, cheapest path
+    SOLVER_JPS,           // A* over jump points only, skipping straight runs, shortest path
+    SOLVER_MODE_COUNT     // number of modes, not a mode itself
+} SolverMode;
+
+// ----- layouts generated by the benchmark -----
+typedef enum {
+    BENCH_PERFECT,    // randomized DFS maze, exactly one path between any two cells
+    BENCH_ROOMS,      // open rooms joined by doors
+    BENCH_SPIRAL,     // a single corridor spiralling inwards, the path covers half the grid
+    BENCH_UNSOLVABLE, // a perfect maze with the exit walled in
+    BENCH_KIND_COUNT
+} BenchKind;
+
+// ----- steps of the benchmark besides the solver modes, which are numbered by SolverMode -----
+#define BENCH_STEP_WRITE (-2)
+#define BENCH_STEP_READ (-1)
+
+// ----- one generated maze of the benchmark, shared by the processes that time its steps -----
+typedef struct {
+    BenchKind kind;    // layout of the maze
+    int size;          // number of rows and columns
+    uint64_t seed;     // seed of the maze generator
+    int threads;       // number of threads for the parallel mode
+    const char *path;  // temporary file the maze is written to and read back from
+} BenchCase;
+
+// ----- a node of the A* open list -----
+typedef struct {
+    uint32_t f;    // g + h, used as the priority
+    uint32_t g;    // distance from the start
+    uint32_t cell; // bit index of the cell
+    uint32_t dir;  // direction the cell is entered with
+} HeapNode;
+
+// ----- binary min-heap used as the A* open list -----
+typedef struct {
+    HeapNode *nodes;
+    size_t size;
+    size_t capacity;
+} MinHeap;
+
+// ----- cells of the next level reached first by one thread of the parallel BFS, or of one cost bucket of the weighted search -----
+typedef struct {
+    uint32_t *cells;
+    size_t size;
+    size_t capacity;
+} FrontierBuffer;
+
+// ----- working memory of the solvers, sized for the largest maze seen so far -----
+typedef struct {
+    uint64_t *visited;       // one bit per cell, same layout as Maze.walls
+    uint8_t *came_from;      // two bits per cell: the direction the cell was entered with
+    uint32_t *queue;         // BFS queue or DFS stack of bit indices
+    uint8_t *next_dir;       // DFS only: next direction to try for every stack entry
+    MinHeap open;            // A* only: open list
+    size_t bits;             // cells covered by visited and came_from
+    size_t cells;            // entries available in queue and next_dir
+    uint64_t *visited_exit;  // bidirectional only: visited bitmap of the search from the exit
+    uint8_t *came_from_exit; // bidirectional only: packed directions of the search from the exit
+    size_t exit_bits;        // cells covered by visited_exit and came_from_exit
+    uint32_t *dist;          // weighted: cheapest known cost of every cell; jps: cost of every expanded cell
+    size_t dist_bits;        // cells covered by dist
+    FrontierBuffer buckets[WEIGHT_MAX + 1]; // weighted only: cells waiting at every cost modulo WEIGHT_MAX + 1
+    size_t explored;         // cells reached by the last solve (jump points expanded, for SOLVER_JPS)
+} SolverScratch;
+
+// ----- one of the two searches of the bidirectional BFS -----
+typedef struct {
+    uint64_t *visited;
+    uint8_t *came_from;
+    uint32_t *queue; // first queue entry
+    long step;       // +1 or -1: the queue grows up or down from its first entry
+    size_t head;
+    size_t tail;
+} SearchSide;
+
+// ----- what the threads of the parallel BFS do with a level -----
+typedef enum {
+    LEVEL_PARALLEL, // every thread expands part of it
+    LEVEL_ALONE,    // thread 0 expands it (and the following small ones) by itself
+    LEVEL_DONE      // the search is over
+} LevelPlan;
+
+// ----- state shared by the threads of the parallel BFS -----
+typedef struct {
+    const Maze *maze;
+    uint64_t *visited;       // shared visited bitmap, updated with atomic ORs
+    uint8_t *came_from;      // shared packed directions
+    uint32_t *frontier;      // cells of the level being expanded
+    uint32_t *next;          // cells of the level being built
+    size_t frontier_size;
+    atomic_size_t cursor;    // first frontier cell not handed out yet
+    FrontierBuffer *buffers; // one per thread
+    int threads;
+    long offset[4];
+    uint32_t end;
+    size_t explored;         // cells reached so far
+    bool done;               // only touched by thread 0, the others follow plan
+    bool failed;             // a thread ran out of memory
+    LevelPlan plan[2];       // plan of the current and the next level, by level parity
+    bool started;            // set once every thread has been created
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    pthread_barrier_t barrier;
+} ParallelBfs;
+
+// ----- argument of a parallel BFS thread -----
+typedef struct {
+    ParallelBfs *bfs;
+    int id;
+} ParallelBfsWorker;
+
+// ----- distance to the exit of every open cell, one uint32 each -----
+typedef struct {
+    uint32_t *dist;    // indexed by the rank of the cell among the open cells, UINT32_MAX if unreachable
+    uint32_t *rank;    // number of open cells before every word of Maze.walls
+    size_t open_cells; // entries in dist
+} DistanceField;
+
+// ----- header of a saved distance field, followed by open_cells distances -----
+typedef struct {
+    char magic[4]; // "MDST"
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t end_row;
+    uint32_t end_col;
+    uint64_t open_cells;
+} DistanceFieldHeader;
+
+// ----- header of a path file, followed by run_count runs (direction << 30 | length) from the start -----
+typedef struct {
+    char magic[4]; // "MPTH"
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t start_row;
+    uint32_t start_col;
+    uint32_t run_count;
+} PathFileHeader;
+
+// ----- one maze of a batch -----
+typedef struct {
+    char *input;    // maze file to solve
+    char *output;   // where the solved maze is written
+    double seconds; // time spent reading, solving and writing it
+    bool solved;
+} BatchJob;
+
+// ----- the jobs of a batch, handed out to the worker threads in order -----
+typedef struct {
+    BatchJob *jobs;
+    size_t count;
+    size_t capacity;
+    atomic_size_t next; // index of the next job to hand out
+    SolverMode mode;
+} BatchQueue;
+
+// ----- a connected component of the streaming reachability check, kept at its root -----
+typedef struct {
+    uint64_t size;      // open cells in the component
+    uint64_t start_seq; // latest 'S' in it, numbered in reading order from 1 (0 if none)
+    uint64_t end_seq;   // latest 'E' in it, numbered in reading order from 1 (0 if none)
+} Component;
+
+// ----- union-find over one band of rows of a streamed maze, plus the last row of the band before it -----
+typedef struct {
+    uint32_t *parent;          // (rows + 1) * cols entries, REACH_WALL for walls; row 0 is the previous band's last row
+    Component *info;           // valid at roots only
+    uint32_t *label;           // boundary column of every root still open at the bottom of the band, REACH_WALL otherwise
+    uint32_t *next_parent;     // the next boundary row, while it is built
+    Component *next_info;      // the components of the next boundary row, while it is built
+    int rows;                  // rows in a band
+    int cols;
+    Component start;           // closed component holding the latest 'S' so far
+} ReachBands;
+
+// ----- command line names of the solver modes, in SolverMode order -----
+const char *solver_mode_names[] = {"backtrack", "bfs", "astar", "parallel", "bidirectional", "weighted", "jps"};
+
 // ----- direction arrays -----
 int dr[] = {-1, 0, 1, 0};
 int dc[] = {0, 1, 0, -1};
@@ -26,55 +266,296 @@ int dc[] = {0, 1, 0, -1};
 // ---------------------
 // ----- FUNCTIONS -----
 // ---------------------
-bool read_maze(const char *filename, Maze *maze) {
+void maze_free(Maze *maze) {
     /*
-     * Function to read a maze from a file
-     *  @param filename: name of the input file
+     * Function for releasing the grid of a maze
+     *  @param maze: pointer to the maze structure
+     * */
+    if (maze->mapped_size > 0) {
+        munmap(maze->grid, maze->mapped_size);
+    } else {
+        free(maze->grid);
+    }
+    free(maze->walls);
+    free(maze->costs);
+    maze->grid = NULL;
+    maze->mapped_size = 0;
+    maze->walls = NULL;
+    maze->costs = NULL;
+    maze->rows = maze->cols = 0;
+}
+
+bool build_wall_bitmap(Maze *maze) {
+    /*
+     * Function for packing the walls of the grid into one bit per cell
      *  @param maze: pointer to the maze structure
      * @return: true if successful, false otherwise
      * */
-    FILE *file = fopen(filename, "r");
-    if (file == NULL) {
-        printf("Error opening input file: %s\n", filename);
+
+    // ----- a wall border around the grid saves the solvers any bounds checks -----
+    maze->bit_stride = ((size_t) maze->cols + 2 + 63) / 64 * 64;
+    size_t bits = ((size_t) maze->rows + 2) * maze->bit_stride;
+    if (bits > UINT32_MAX) {
+        printf("Error: The maze is too large.\n");
+        return false;
+    }
+
+    maze->walls = malloc(bits / 8);
+    if (maze->walls == NULL) {
+        printf("Error: Not enough memory to read the maze.\n");
+        return false;
+    }
+    memset(maze->walls, 0xff, bits / 8);
+
+    // ----- clearing the bit of every open cell -----
+    for (int row = 0; row < maze->rows; row++) {
+        const char *cells = &MAZE_CELL(maze, row, 0);
+        uint32_t bit = MAZE_BIT(maze, row, 0);
+
+        for (int col = 0; col < maze->cols; col++, bit++) {
+            if (cells[col] != '#') {
+                maze->walls[bit >> 6] &= ~((uint64_t) 1 << (bit & 63));
+            }
+        }
+    }
+
+    return true;
+}
+
+bool build_cost_map(Maze *maze) {
+    /*
+     * Function for reading the terrain cost of every cell, if the maze has any digits
+     *  @param maze: pointer to the maze structure, with its wall bitmap built
+     * @return: true if successful, false otherwise
+     * */
+    size_t bits = ((size_t) maze->rows + 2) * maze->bit_stride;
+
+    for (int row = 0; row < maze->rows; row++) {
+        const char *cells = &MAZE_CELL(maze, row, 0);
+        uint32_t bit = MAZE_BIT(maze, row, 0);
+
+        for (int col = 0; col < maze->cols; col++, bit++) {
+            if (cells[col] < '1' || cells[col] > '9') {
+                continue;
+            }
+
+            // ----- the map is only allocated once the first digit shows up, plain mazes never pay for it -----
+            if (maze->costs == NULL) {
+                maze->costs = malloc(bits);
+                if (maze->costs == NULL) {
+                    printf("Error: Not enough memory to read the maze.\n");
+                    return false;
+                }
+                memset(maze->costs, 1, bits);
+            }
+            maze->costs[bit] = (uint8_t) (cells[col] - '0');
+        }
+    }
+
+    return true;
+}
+
+bool map_maze(int fd, size_t size, Maze *maze) {
+    /*
+     * Function for using a memory-mapped maze file directly as the grid, without copying it
+     *  @param fd: descriptor of the open maze file
+     *  @param size: size of the file in bytes
+     *  @param maze: pointer to the maze structure
+     * @return: true if the file was mapped, false if it has to be read line by line instead
+     * */
+
+    // ----- a private mapping lets the solvers mark the path without touching the file -----
+    char *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+
+    // ----- the layout only works if every line has the same length and ends with '\n' -----
+    const char *newline = memchr(data, '\n', size);
+    size_t stride = newline ? (size_t) (newline - data) + 1 : 0;
+    bool uniform = stride > 1 && data[stride - 2] != '\r' && size % stride == 0 &&
+                   (size / stride) * (stride - 1) <= INT_MAX;
+
+    // ----- checking that the next newline always sits exactly one stride further -----
+    for (size_t offset = stride; uniform && offset < size; offset += stride) {
+        newline = memchr(data + offset, '\n', stride);
+        uniform = newline == data + offset + stride - 1;
+    }
+    if (!uniform) {
+        munmap(data, size);
+        return false;
+    }
+
+    maze->grid = data;
+    maze->mapped_size = size;
+    maze->stride = stride;
+    maze->cols = (int) (stride - 1);
+    maze->rows = (int) (size / stride);
+
+    // ----- locating the last 'S' and 'E', as the line by line reader does -----
+    const char *start = memrchr(data, 'S', size);
+    const char *end = memrchr(data, 'E', size);
+    if (start != NULL) {
+        maze->start_row = (int) ((size_t) (start - data) / stride);
+        maze->start_col = (int) ((size_t) (start - data) % stride);
+    }
+    if (end != NULL) {
+        maze->end_row = (int) ((size_t) (end - data) / stride);
+        maze->end_col = (int) ((size_t) (end - data) % stride);
+    }
+
+    return true;
+}
+
+bool read_maze_stream(FILE *file, const char *filename, Maze *maze) {
+    /*
+     * Function to read a maze line by line into a grid sized exactly to its contents
+     *  @param file: stream to read from (a file, a pipe or stdin)
+     *  @param filename: name of the input, for error messages
+     *  @param maze: pointer to the maze structure
+     * @return: true if successful, false otherwise
+     * */
+
+    // ----- the first line gives the column count -----
+    char *line = NULL;
+    size_t line_capacity = 0;
+    ssize_t length = getline(&line, &line_capacity, file);
+    while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+        length--;
+    }
+    if (length <= 0) {
+        printf("Error: The maze file is empty: %s\n", filename);
+        free(line);
         return false;
     }
+    maze->cols = (int) length;
+    maze->stride = (size_t) length + 1;
+
+    // ----- guessing the row count from the file size, so regular files need a single allocation -----
+    struct stat info;
+    size_t capacity = 64;
+    if (fstat(fileno(file), &info) == 0 && S_ISREG(info.st_mode)) {
+        capacity = (size_t) info.st_size / maze->stride + 1;
+    }
+    maze->grid = malloc(capacity * maze->stride);
 
     // ----- reading the maze line by line -----
-    char line[MAX_SIZE + 2];
     int row = 0;
+    const char *error = maze->grid == NULL ? "Not enough memory to read the maze" : NULL;
+    while (error == NULL && length >= 0) {
+        if ((size_t) row == capacity) {
+            capacity *= 2;
+            char *grid = realloc(maze->grid, capacity * maze->stride);
+            if (grid == NULL) {
+                error = "Not enough memory to read the maze";
+                break;
+            }
+            maze->grid = grid;
+        }
 
-    while (fgets(line, sizeof(line), file) && row < MAX_SIZE) {
+        // ----- copying the row, padding short rows with walls and cutting long ones -----
+        char *cells = &MAZE_CELL(maze, row, 0);
         int col = 0;
+        for (; col < maze->cols && col < length && line[col] != '\n' && line[col] != '\r'; col++) {
+            cells[col] = line[col];
 
-        // ----- processing each character in the line -----
-        for (int i = 0; line[i] != '\0' && line[i] != '\n' && col < MAX_SIZE; i++, col++) {
-            maze->grid[row][col] = line[i];
-
-            if (line[i] == 'S') {
+            if (line[col] == 'S') {
                 // ----- recording the start position -----
                 maze->start_row = row;
                 maze->start_col = col;
-            } else if (line[i] == 'E') {
+            } else if (line[col] == 'E') {
                 // ----- recording the end position -----
                 maze->end_row = row;
                 maze->end_col = col;
             }
         }
+        memset(cells + col, '#', maze->cols - col);
+        cells[maze->cols] = '\n';
 
-        // ----- updating columns count (for the first row only) -----
-        if (row == 0) {
-            maze->cols = col;
+        // ----- cells are indexed with an int by the solvers -----
+        row++;
+        if ((size_t) row * maze->cols > INT_MAX) {
+            error = "The maze is too large";
         }
+        length = getline(&line, &line_capacity, file);
+    }
 
-        row++;
+    free(line);
+    if (error != NULL) {
+        printf("Error: %s: %s\n", error, filename);
+        maze_free(maze);
+        return false;
     }
 
+    // ----- giving back the memory of an overestimated row count -----
     maze->rows = row;
-    fclose(file);
+    char *grid = realloc(maze->grid, (size_t) row * maze->stride);
+    if (grid != NULL) {
+        maze->grid = grid;
+    }
+
+    return true;
+}
+
+bool read_maze(const char *filename, Maze *maze) {
+    /*
+     * Function to read a maze from a file, mapping regular files and reading "-" from stdin
+     *  @param filename: name of the input file
+     *  @param maze: pointer to the maze structure
+     * @return: true if successful, false otherwise
+     * */
+    maze->grid = NULL;
+    maze->walls = NULL;
+    maze->costs = NULL;
+    maze->mapped_size = 0;
+    maze->rows = maze->cols = 0;
+    maze->start_row = maze->start_col = -1;
+    maze->end_row = maze->end_col = -1;
+
+    bool ok;
+    if (strcmp(filename, "-") == 0) {
+        ok = read_maze_stream(stdin, "stdin", maze);
+    } else {
+        int fd = open(filename, O_RDONLY);
+        if (fd < 0) {
+            printf("Error opening input file: %s\n", filename);
+            return false;
+        }
+
+        // ----- regular files are mapped, anything else (or an irregular layout) is read line by line -----
+        struct stat info;
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0 &&
+            map_maze(fd, (size_t) info.st_size, maze)) {
+            maze->mapped_dev = info.st_dev;
+            maze->mapped_ino = info.st_ino;
+            close(fd);
+            ok = true;
+        } else {
+            FILE *file = fdopen(fd, "r");
+            if (file == NULL) {
+                printf("Error opening input file: %s\n", filename);
+                close(fd);
+                return false;
+            }
+            ok = read_maze_stream(file, filename, maze);
+            fclose(file);
+        }
+    }
+    if (!ok) {
+        return false;
+    }
 
     // ----- validating that we found start and end positions -----
-    if (maze->grid[maze->start_row][maze->start_col] != 'S' || maze->grid[maze->end_row][maze->end_col] != 'E') {
+    if (maze->start_row < 0 || maze->end_row < 0) {
         printf("Error: Could not find start 'S' or end 'E' in the maze.\n");
+        maze_free(maze);
+        return false;
+    }
+
+    // ----- packing the walls and the terrain costs once, for the solvers -----
+    if (!build_wall_bitmap(maze) || !build_cost_map(maze)) {
+        maze_free(maze);
         return false;
     }
 
@@ -84,114 +565,2213 @@ bool read_maze(const char *filename, Maze *maze) {
 bool write_maze(const char *filename, const Maze *maze) {
     /*
      * Function to write the maze to a file
-     *  @param filename: name of the output file
+     *  @param filename: name of the output file (may be the file the maze was mapped from)
      *  @param maze: pointer to the maze structure
      * @return: true if successful, false otherwise
      * */
-    FILE *file = fopen(filename, "w");
-    if (file == NULL) {
+    const char *data = maze->grid;
+    size_t left = (size_t) maze->rows * maze->stride;
+
+    // ----- truncating the file the grid is mapped from would take the grid with it, so that case writes a copy -----
+    char *copy = NULL;
+    struct stat info;
+    if (maze->mapped_size > 0 && stat(filename, &info) == 0 &&
+        info.st_dev == maze->mapped_dev && info.st_ino == maze->mapped_ino) {
+        copy = malloc(left > 0 ? left : 1);
+        if (copy == NULL) {
+            printf("Error: Not enough memory to write over the input file: %s\n", filename);
+            return false;
+        }
+        memcpy(copy, data, left);
+        data = copy;
+    }
+
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
         printf("Error opening output file: %s\n", filename);
+        free(copy);
         return false;
     }
 
-    for (int row = 0; row < maze->rows; row++) {
-        for (int col = 0; col < maze->cols; col++) {
-            fprintf(file, "%c", maze->grid[row][col]);
+    // ----- every row already ends with '\n', so the grid is the file: one block write -----
+    while (left > 0) {
+        ssize_t written = write(fd, data, left);
+        if (written < 0) {
+            printf("Error writing output file: %s\n", filename);
+            close(fd);
+            free(copy);
+            return false;
         }
-        fprintf(file, "\n");
+        data += written;
+        left -= (size_t) written;
     }
 
-    fclose(file);
+    close(fd);
+    free(copy);
     return true;
 }
 
-bool is_valid_move(const Maze *maze, int row, int col, bool visited[MAX_SIZE][MAX_SIZE]) {
+bool is_valid_move(const Maze *maze, const uint64_t *visited, uint32_t cell) {
     /*
      * Function for checking if a move is valid
      *  @param maze: pointer to the maze structure
-     *  @param row: row index
-     *  @param col: column index
-     *  @param visited: 2D array to track visited cells
+     *  @param visited: bitmap of the cells visited so far
+     *  @param cell: bit index of the cell to move into
      * @return: true if valid, false otherwise
      * */
 
-    // ----- checking if within bounds -----
-    if (row < 0 || row >= maze->rows || col < 0 || col >= maze->cols) {
-        return false;
+    // ----- a single test covers walls, visited cells and (thanks to the border) the bounds -----
+    return !(((maze->walls[cell >> 6] | visited[cell >> 6]) >> (cell & 63)) & 1);
+}
+
+void direction_offsets(const Maze *maze, long offset[4]) {
+    /*
+     * Function for turning the direction arrays into bit index offsets
+     *  @param maze: pointer to the maze structure
+     *  @param offset: where to store the offset of each direction
+     * */
+    for (int i = 0; i < 4; i++) {
+        offset[i] = dr[i] * (long) maze->bit_stride + dc[i];
+    }
+}
+
+void dir_set(uint8_t *dirs, uint32_t cell, int dir) {
+    /*
+     * Function for storing the two-bit direction a cell was entered with
+     *  @param dirs: packed direction array
+     *  @param cell: bit index of the cell
+     *  @param dir: index into the direction arrays
+     * */
+    int shift = (cell & 3) * 2;
+    dirs[cell >> 2] = (uint8_t) ((dirs[cell >> 2] & ~(3 << shift)) | (dir << shift));
+}
+
+void scratch_free(SolverScratch *scratch) {
+    /*
+     * Function for releasing the working memory of the solvers
+     *  @param scratch: pointer to the scratch buffers
+     * */
+    free(scratch->visited);
+    free(scratch->came_from);
+    free(scratch->queue);
+    free(scratch->next_dir);
+    free(scratch->open.nodes);
+    free(scratch->visited_exit);
+    free(scratch->came_from_exit);
+    free(scratch->dist);
+    for (int i = 0; i <= WEIGHT_MAX; i++) {
+        free(scratch->buckets[i].cells);
+    }
+    memset(scratch, 0, sizeof(SolverScratch));
+}
+
+bool scratch_prepare(SolverScratch *scratch, const Maze *maze) {
+    /*
+     * Function for making the scratch buffers large enough for a maze and clearing the visited set
+     *  @param scratch: pointer to the scratch buffers
+     *  @param maze: pointer to the maze structure
+     * @return: true if successful, false if out of memory
+     * */
+    size_t bits = ((size_t) maze->rows + 2) * maze->bit_stride;
+    size_t cells = (size_t) maze->rows * maze->cols;
+
+    // ----- growing only, so the buffers can be reused across mazes -----
+    if (bits > scratch->bits) {
+        free(scratch->visited);
+        free(scratch->came_from);
+        scratch->visited = malloc(bits / 8);
+        scratch->came_from = malloc(bits / 4);
+        scratch->bits = scratch->visited && scratch->came_from ? bits : 0;
+        if (scratch->bits == 0) {
+            return false;
+        }
+    }
+    if (cells > scratch->cells) {
+        free(scratch->queue);
+        free(scratch->next_dir);
+        scratch->queue = malloc(cells * sizeof(uint32_t));
+        scratch->next_dir = malloc(cells * sizeof(uint8_t));
+        scratch->cells = scratch->queue && scratch->next_dir ? cells : 0;
+        if (scratch->cells == 0) {
+            return false;
+        }
+    }
+
+    memset(scratch->visited, 0, bits / 8);
+    scratch->open.size = 0;
+    scratch->explored = 0;
+    return true;
+}
+
+bool scratch_prepare_exit(SolverScratch *scratch, const Maze *maze) {
+    /*
+     * Function for making the buffers of the search from the exit large enough and clearing them
+     *  @param scratch: pointer to the scratch buffers
+     *  @param maze: pointer to the maze structure
+     * @return: true if successful, false if out of memory
+     * */
+    size_t bits = ((size_t) maze->rows + 2) * maze->bit_stride;
+
+    if (bits > scratch->exit_bits) {
+        free(scratch->visited_exit);
+        free(scratch->came_from_exit);
+        scratch->visited_exit = malloc(bits / 8);
+        scratch->came_from_exit = malloc(bits / 4);
+        scratch->exit_bits = scratch->visited_exit && scratch->came_from_exit ? bits : 0;
+        if (scratch->exit_bits == 0) {
+            return false;
+        }
+    }
+
+    memset(scratch->visited_exit, 0, bits / 8);
+    return true;
+}
+
+bool scratch_reserve_dist(SolverScratch *scratch, const Maze *maze) {
+    /*
+     * Function for making the per-cell cost array large enough, without clearing it
+     *  @param scratch: pointer to the scratch buffers
+     *  @param maze: pointer to the maze structure
+     * @return: true if successful, false if out of memory
+     * */
+    size_t bits = ((size_t) maze->rows + 2) * maze->bit_stride;
+
+    if (bits > scratch->dist_bits) {
+        free(scratch->dist);
+        scratch->dist = malloc(bits * sizeof(uint32_t));
+        scratch->dist_bits = scratch->dist ? bits : 0;
     }
+    return scratch->dist_bits > 0;
+}
 
-    // ----- checking if it's a wall or already visited -----
-    if (maze->grid[row][col] == '#' || visited[row][col]) {
+bool scratch_prepare_weighted(SolverScratch *scratch, const Maze *maze) {
+    /*
+     * Function for making the cost array of the weighted search large enough and clearing it
+     *  @param scratch: pointer to the scratch buffers
+     *  @param maze: pointer to the maze structure
+     * @return: true if successful, false if out of memory
+     * */
+    size_t bits = ((size_t) maze->rows + 2) * maze->bit_stride;
+    if (!scratch_reserve_dist(scratch, maze)) {
         return false;
     }
 
+    memset(scratch->dist, 0xff, bits * sizeof(uint32_t));
+    for (int i = 0; i <= WEIGHT_MAX; i++) {
+        scratch->buckets[i].size = 0;
+    }
     return true;
 }
 
-bool solve_maze(Maze *maze, int row, int col, bool visited[MAX_SIZE][MAX_SIZE]) {
+void mark_cell(Maze *maze, uint32_t cell) {
     /*
-     * Function for solving the maze using backtracking
+     * Function for marking a cell of a path with a dot, unless it is the start or the end
      *  @param maze: pointer to the maze structure
-     *  @param row: current row index
-     *  @param col: current column index
-     *  @param visited: 2D array to track visited cells
-     * @return: true if a solution is found, false otherwise
+     *  @param cell: bit index of the cell
      * */
+    char *c = &MAZE_CELL(maze, cell / maze->bit_stride - 1, cell % maze->bit_stride - 1);
+    if (*c != 'S' && *c != 'E') {
+        *c = '.';
+    }
+}
 
-    // ----- marking the current cell as visited -----
-    visited[row][col] = true;
+void mark_chain(Maze *maze, const uint8_t *came_from, uint32_t cell, uint32_t root) {
+    /*
+     * Function for marking the cells on the way back from a cell to the root of its search
+     *  @param maze: pointer to the maze structure
+     *  @param came_from: packed directions every cell of the search was entered with
+     *  @param cell: bit index of the cell to start from (not marked itself)
+     *  @param root: bit index of the cell the search started from
+     * */
+    long offset[4];
+    direction_offsets(maze, offset);
 
-    // ----- once we have reached the exit, we're done -----
-    if (row == maze->end_row && col == maze->end_col) {
-        return true;
+    while (cell != root) {
+        cell = (uint32_t) (cell - offset[DIR_GET(came_from, cell)]);
+        mark_cell(maze, cell);
     }
+}
 
-    // ----- trying all possible moves -----
-    for (int i = 0; i < 4; i++) {
-        int new_row = row + dr[i];
-        int new_col = col + dc[i];
+void mark_path(Maze *maze, const SolverScratch *scratch) {
+    /*
+     * Function for marking the path found by a solver into the grid
+     *  @param maze: pointer to the maze structure
+     *  @param scratch: scratch buffers holding the direction every cell was entered with
+     * */
 
-        if (is_valid_move(maze, new_row, new_col, visited)) {
-            // ----- marking the path with a dot if it's not start or end -----
-            if (maze->grid[new_row][new_col] != 'S' && maze->grid[new_row][new_col] != 'E') {
-                maze->grid[new_row][new_col] = '.';
-            }
+    // ----- walking back from the exit, marking every cell except start and end -----
+    mark_chain(maze, scratch->came_from, MAZE_BIT(maze, maze->end_row, maze->end_col),
+               MAZE_BIT(maze, maze->start_row, maze->start_col));
+}
 
-            // ----- recursive calling to continue path finding -----
-            if (solve_maze(maze, new_row, new_col, visited)) {
-                return true;
-            }
+bool solve_maze_backtrack(Maze *maze, SolverScratch *scratch) {
+    /*
+     * Function for solving the maze using backtracking, with an explicit stack instead of recursion
+     *  @param maze: pointer to the maze structure
+     *  @param scratch: prepared scratch buffers
+     * @return: true if a solution is found, false otherwise
+     * */
+    long offset[4];
+    direction_offsets(maze, offset);
+    uint32_t start = MAZE_BIT(maze, maze->start_row, maze->start_col);
+    uint32_t end = MAZE_BIT(maze, maze->end_row, maze->end_col);
 
-            if (maze->grid[new_row][new_col] == '.') {
-                maze->grid[new_row][new_col] = ' ';
-            }
+    // ----- every stack entry remembers which direction to try next -----
+    uint32_t *stack = scratch->queue;
+    size_t top = 0;
+    stack[top] = start;
+    scratch->next_dir[top++] = 0;
+    BIT_SET(scratch->visited, start);
+    scratch->explored = 1;
+
+    while (top > 0) {
+        uint32_t cell = stack[top - 1];
+
+        // ----- once we have reached the exit, we're done -----
+        if (cell == end) {
+            return true;
+        }
+
+        // ----- all directions tried, backtracking -----
+        if (scratch->next_dir[top - 1] == 4) {
+            top--;
+            continue;
+        }
+
+        int i = scratch->next_dir[top - 1]++;
+        uint32_t next = (uint32_t) (cell + offset[i]);
+
+        if (is_valid_move(maze, scratch->visited, next)) {
+            BIT_SET(scratch->visited, next);
+            dir_set(scratch->came_from, next, i);
+            scratch->explored++;
+            stack[top] = next;
+            scratch->next_dir[top++] = 0;
         }
     }
 
     return false;
 }
 
-int main() {
+int first_visited_neighbour(const uint64_t *visited, const long offset[4], uint32_t cell) {
+    /*
+     * Function for choosing the parent of a cell the same way in the sequential and the parallel BFS
+     *  @param visited: bitmap of the cells reached so far
+     *  @param offset: bit index offset of every direction
+     *  @param cell: bit index of a cell just reached
+     * @return: index of the first direction the cell can be entered with from a visited neighbour
+     * */
 
-    // ----- reading the maze from input file -----
-    char *input_file = "inputData/small_maze.dat";
-    Maze maze;
-    bool visited[MAX_SIZE][MAX_SIZE] = {false};
-    if (!read_maze(input_file, &maze)) {
-        return 1;
+    // ----- the grid is bipartite, so while a level is being discovered its visited neighbours all belong to the previous level -----
+    for (int i = 0; i < 4; i++) {
+        if (BIT_TEST(visited, (uint32_t) (cell - offset[i]))) {
+            return i;
+        }
     }
+    return 0;
+}
 
-    // ----- solving the maze using backtracking -----
-    if (!solve_maze(&maze, maze.start_row, maze.start_col, visited)) {
-        printf("No solution found for the maze.\n");
-        return 1;
-    }
+bool solve_maze_bfs(Maze *maze, SolverScratch *scratch) {
+    /*
+     * Function for solving the maze using breadth-first search
+     *  @param maze: pointer to the maze structure
+     *  @param scratch: prepared scratch buffers
+     * @return: true if a solution is found, false otherwise
+     * */
+    long offset[4];
+    direction_offsets(maze, offset);
+    uint32_t start = MAZE_BIT(maze, maze->start_row, maze->start_col);
+    uint32_t end = MAZE_BIT(maze, maze->end_row, maze->end_col);
 
-    // ----- writing the solution to an output file -----
-    if (!write_maze("output_maze.dat", &maze)) {
-        return 1;
-    }
+    // ----- every cell is enqueued at most once, so the queue never wraps -----
+    uint32_t *queue = scratch->queue;
+    size_t head = 0, tail = 0, level_end = 1;
+    queue[tail++] = start;
+    BIT_SET(scratch->visited, start);
 
-    printf("Maze solved successfully!\n");
-    return 0;
-}
\ No newline at end of file
+    while (head < tail) {
+        // ----- a level is complete when the one before it has been expanded: fixing its parents -----
+        if (head == level_end) {
+            for (size_t k = head; k < tail; k++) {
+                dir_set(scratch->came_from, queue[k], first_visited_neighbour(scratch->visited, offset, queue[k]));
+            }
+            level_end = tail;
+        }
+
+        uint32_t cell = queue[head++];
+
+        if (cell == end) {
+            scratch->explored = tail;
+            return true;
+        }
+
+        // ----- enqueuing all unvisited neighbours -----
+        for (int i = 0; i < 4; i++) {
+            uint32_t next = (uint32_t) (cell + offset[i]);
+
+            if (is_valid_move(maze, scratch->visited, next)) {
+                BIT_SET(scratch->visited, next);
+                queue[tail++] = next;
+            }
+        }
+    }
+
+    scratch->explored = tail;
+    return false;
+}
+
+bool heap_push(MinHeap *heap, HeapNode node) {
+    /*
+     * Function for inserting a node into the min-heap
+     *  @param heap: pointer to the heap
+     *  @param node: node to insert
+     * @return: true if successful, false if out of memory
+     * */
+    if (heap->size == heap->capacity) {
+        size_t capacity = heap->capacity ? heap->capacity * 2 : 1024;
+        HeapNode *nodes = realloc(heap->nodes, capacity * sizeof(HeapNode));
+        if (nodes == NULL) {
+            return false;
+        }
+        heap->nodes = nodes;
+        heap->capacity = capacity;
+    }
+
+    // ----- sifting up; ties on f prefer the node closer to the exit (larger g) -----
+    size_t i = heap->size++;
+    while (i > 0) {
+        size_t up = (i - 1) / 2;
+        HeapNode *p = &heap->nodes[up];
+        if (p->f < node.f || (p->f == node.f && p->g >= node.g)) {
+            break;
+        }
+        heap->nodes[i] = *p;
+        i = up;
+    }
+    heap->nodes[i] = node;
+    return true;
+}
+
+HeapNode heap_pop(MinHeap *heap) {
+    /*
+     * Function for removing the smallest node from a non-empty min-heap
+     *  @param heap: pointer to the heap
+     * @return: the removed node
+     * */
+    HeapNode top = heap->nodes[0];
+    HeapNode last = heap->nodes[--heap->size];
+
+    // ----- sifting the last node down from the root -----
+    size_t i = 0;
+    while (2 * i + 1 < heap->size) {
+        size_t child = 2 * i + 1;
+        HeapNode *c = &heap->nodes[child];
+        if (child + 1 < heap->size) {
+            HeapNode *r = &heap->nodes[child + 1];
+            if (r->f < c->f || (r->f == c->f && r->g > c->g)) {
+                child++;
+                c = r;
+            }
+        }
+        if (last.f < c->f || (last.f == c->f && last.g >= c->g)) {
+            break;
+        }
+        heap->nodes[i] = *c;
+        i = child;
+    }
+    heap->nodes[i] = last;
+    return top;
+}
+
+bool solve_maze_astar(Maze *maze, SolverScratch *scratch) {
+    /*
+     * Function for solving the maze using A* with the Manhattan distance heuristic
+     *  @param maze: pointer to the maze structure
+     *  @param scratch: prepared scratch buffers
+     * @return: true if a solution is found, false otherwise
+     * */
+    long offset[4];
+    direction_offsets(maze, offset);
+    uint32_t start = MAZE_BIT(maze, maze->start_row, maze->start_col);
+    uint32_t end = MAZE_BIT(maze, maze->end_row, maze->end_col);
+    MinHeap *open = &scratch->open;
+
+    // ----- the heuristic is consistent, so a cell is final (and visited) the first time it is popped -----
+    uint32_t h = (uint32_t) (abs(maze->start_row - maze->end_row) + abs(maze->start_col - maze->end_col));
+    bool ok = heap_push(open, (HeapNode) {h, 0, start, 0});
+    while (ok && open->size > 0) {
+        HeapNode node = heap_pop(open);
+
+        // ----- skipping stale entries of cells already reached by a shorter route -----
+        if (BIT_TEST(scratch->visited, node.cell)) {
+            continue;
+        }
+        BIT_SET(scratch->visited, node.cell);
+        dir_set(scratch->came_from, node.cell, (int) node.dir);
+        scratch->explored++;
+
+        if (node.cell == end) {
+            return true;
+        }
+
+        for (int i = 0; i < 4 && ok; i++) {
+            uint32_t next = (uint32_t) (node.cell + offset[i]);
+
+            if (is_valid_move(maze, scratch->visited, next)) {
+                int row = (int) (next / maze->bit_stride) - 1;
+                int col = (int) (next % maze->bit_stride) - 1;
+                h = (uint32_t) (abs(row - maze->end_row) + abs(col - maze->end_col));
+                ok = heap_push(open, (HeapNode) {node.g + 1 + h, node.g + 1, next, (uint32_t) i});
+            }
+        }
+    }
+
+    if (!ok) {
+        printf("Error: Not enough memory to solve the maze.\n");
+    }
+    return false;
+}
+
+bool frontier_push(FrontierBuffer *buffer, uint32_t cell) {
+    /*
+     * Function for appending a cell to a thread's frontier buffer
+     *  @param buffer: pointer to the buffer
+     *  @param cell: bit index of the cell
+     * @return: true if successful, false if out of memory
+     * */
+    if (buffer->size == buffer->capacity) {
+        size_t capacity = buffer->capacity ? buffer->capacity * 2 : 4096;
+        uint32_t *cells = realloc(buffer->cells, capacity * sizeof(uint32_t));
+        if (cells == NULL) {
+            return false;
+        }
+        buffer->cells = cells;
+        buffer->capacity = capacity;
+    }
+    buffer->cells[buffer->size++] = cell;
+    return true;
+}
+
+void parallel_bfs_expand(ParallelBfs *bfs, FrontierBuffer *out) {
+    /*
+     * Function for expanding chunks of the current level until none are left
+     *  @param bfs: shared state of the parallel BFS
+     *  @param out: buffer collecting the cells this thread reaches first
+     * */
+    const uint64_t *walls = bfs->maze->walls;
+    size_t begin;
+
+    while ((begin = atomic_fetch_add(&bfs->cursor, PARALLEL_BFS_CHUNK)) < bfs->frontier_size) {
+        size_t end = begin + PARALLEL_BFS_CHUNK < bfs->frontier_size ? begin + PARALLEL_BFS_CHUNK : bfs->frontier_size;
+
+        for (size_t k = begin; k < end; k++) {
+            for (int i = 0; i < 4; i++) {
+                uint32_t next = (uint32_t) (bfs->frontier[k] + bfs->offset[i]);
+                uint64_t mask = (uint64_t) 1 << (next & 63);
+
+                // ----- a plain load filters most visited cells before paying for the atomic -----
+                if (BIT_TEST(walls, next) || (__atomic_load_n(&bfs->visited[next >> 6], __ATOMIC_RELAXED) & mask)) {
+                    continue;
+                }
+                if (__atomic_fetch_or(&bfs->visited[next >> 6], mask, __ATOMIC_RELAXED) & mask) {
+                    continue;
+                }
+                if (!frontier_push(out, next)) {
+                    __atomic_store_n(&bfs->failed, true, __ATOMIC_RELAXED);
+                }
+            }
+        }
+    }
+}
+
+void parallel_bfs_collect(ParallelBfs *bfs, int id) {
+    /*
+     * Function for copying a thread's part of the new level into place and fixing its parents
+     *  @param bfs: shared state of the parallel BFS
+     *  @param id: index of the thread
+     * */
+    size_t at = 0;
+    for (int j = 0; j < id; j++) {
+        at += bfs->buffers[j].size;
+    }
+
+    const FrontierBuffer *buffer = &bfs->buffers[id];
+    for (size_t k = 0; k < buffer->size; k++) {
+        uint32_t cell = buffer->cells[k];
+        bfs->next[at + k] = cell;
+
+        // ----- neighbouring cells share a byte of came_from, so the two bits are replaced atomically -----
+        int shift = (cell & 3) * 2;
+        uint8_t dir = (uint8_t) (first_visited_neighbour(bfs->visited, bfs->offset, cell) << shift);
+        __atomic_fetch_and(&bfs->came_from[cell >> 2], (uint8_t) ~(3 << shift), __ATOMIC_RELAXED);
+        __atomic_fetch_or(&bfs->came_from[cell >> 2], dir, __ATOMIC_RELAXED);
+    }
+}
+
+void parallel_bfs_advance(ParallelBfs *bfs) {
+    /*
+     * Function for making the level just built the current one (a single thread calls it)
+     *  @param bfs: shared state of the parallel BFS
+     * */
+    size_t total = 0;
+    for (int j = 0; j < bfs->threads; j++) {
+        total += bfs->buffers[j].size;
+        bfs->buffers[j].size = 0;
+    }
+
+    uint32_t *level = bfs->frontier;
+    bfs->frontier = bfs->next;
+    bfs->next = level;
+    bfs->frontier_size = total;
+    bfs->explored += total;
+    atomic_store(&bfs->cursor, 0);
+    bfs->done = total == 0 || bfs->failed || BIT_TEST(bfs->visited, bfs->end);
+}
+
+void *parallel_bfs_worker(void *arg) {
+    /*
+     * Function run by every thread of the parallel BFS, one level at a time
+     *  @param arg: pointer to the ParallelBfsWorker of the thread
+     * */
+    ParallelBfsWorker *worker = arg;
+    ParallelBfs *bfs = worker->bfs;
+    int id = worker->id;
+
+    // ----- waiting until the pool is complete, so the barrier knows how many threads there are -----
+    pthread_mutex_lock(&bfs->lock);
+    while (!bfs->started) {
+        pthread_cond_wait(&bfs->ready, &bfs->lock);
+    }
+    pthread_mutex_unlock(&bfs->lock);
+
+    // ----- thread 0 plans a level ahead, in the slot nobody is reading yet -----
+    for (unsigned level = 0; bfs->plan[level & 1] != LEVEL_DONE; level++) {
+        LevelPlan *next_plan = &bfs->plan[(level + 1) & 1];
+
+        if (bfs->plan[level & 1] == LEVEL_ALONE) {
+            // ----- small levels are cheaper on one thread than behind three barriers -----
+            if (id == 0) {
+                while (!bfs->done && bfs->frontier_size < PARALLEL_BFS_MIN_FRONTIER) {
+                    parallel_bfs_expand(bfs, &bfs->buffers[0]);
+                    parallel_bfs_collect(bfs, 0);
+                    parallel_bfs_advance(bfs);
+                }
+                *next_plan = bfs->done ? LEVEL_DONE : LEVEL_PARALLEL;
+            }
+            pthread_barrier_wait(&bfs->barrier);
+            continue;
+        }
+
+        parallel_bfs_expand(bfs, &bfs->buffers[id]);
+        pthread_barrier_wait(&bfs->barrier);
+
+        parallel_bfs_collect(bfs, id);
+        pthread_barrier_wait(&bfs->barrier);
+
+        if (id == 0) {
+            parallel_bfs_advance(bfs);
+            *next_plan = bfs->done ? LEVEL_DONE :
+                         bfs->frontier_size < PARALLEL_BFS_MIN_FRONTIER ? LEVEL_ALONE : LEVEL_PARALLEL;
+        }
+        pthread_barrier_wait(&bfs->barrier);
+    }
+
+    return NULL;
+}
+
+bool solve_maze_parallel_bfs(Maze *maze, SolverScratch *scratch, int threads) {
+    /*
+     * Function for solving the maze using a level-synchronous BFS spread over several threads
+     *  @param maze: pointer to the maze structure
+     *  @param scratch: prepared scratch buffers
+     *  @param threads: number of threads to use
+     * @return: true if a solution is found, false otherwise
+     * */
+    ParallelBfs bfs = {0};
+    bfs.maze = maze;
+    bfs.visited = scratch->visited;
+    bfs.came_from = scratch->came_from;
+    bfs.end = MAZE_BIT(maze, maze->end_row, maze->end_col);
+    direction_offsets(maze, bfs.offset);
+
+    // ----- two levels are alive at a time, the scratch queue holds one of them -----
+    size_t cells = (size_t) maze->rows * maze->cols;
+    bfs.frontier = scratch->queue;
+    bfs.next = malloc(cells * sizeof(uint32_t));
+    bfs.buffers = calloc(threads, sizeof(FrontierBuffer));
+    ParallelBfsWorker *workers = malloc(threads * sizeof(ParallelBfsWorker));
+    pthread_t *pool = malloc(threads * sizeof(pthread_t));
+    if (bfs.next == NULL || bfs.buffers == NULL || workers == NULL || pool == NULL) {
+        printf("Error: Not enough memory to solve the maze.\n");
+        free(bfs.next);
+        free(bfs.buffers);
+        free(workers);
+        free(pool);
+        return false;
+    }
+    uint32_t *own = bfs.next;
+
+    uint32_t start = MAZE_BIT(maze, maze->start_row, maze->start_col);
+    BIT_SET(bfs.visited, start);
+    bfs.frontier[0] = start;
+    bfs.frontier_size = 1;
+    bfs.explored = 1;
+    bfs.done = start == bfs.end;
+    bfs.plan[0] = bfs.done ? LEVEL_DONE : LEVEL_ALONE;
+
+    // ----- the calling thread is worker 0; the others are held back until the pool is complete -----
+    pthread_mutex_init(&bfs.lock, NULL);
+    pthread_cond_init(&bfs.ready, NULL);
+    int running = 1;
+    for (; running < threads; running++) {
+        workers[running] = (ParallelBfsWorker) {&bfs, running};
+        if (pthread_create(&pool[running], NULL, parallel_bfs_worker, &workers[running]) != 0) {
+            break;
+        }
+    }
+    bfs.threads = running;
+    pthread_barrier_init(&bfs.barrier, NULL, running);
+
+    pthread_mutex_lock(&bfs.lock);
+    bfs.started = true;
+    pthread_cond_broadcast(&bfs.ready);
+    pthread_mutex_unlock(&bfs.lock);
+
+    workers[0] = (ParallelBfsWorker) {&bfs, 0};
+    parallel_bfs_worker(&workers[0]);
+    for (int i = 1; i < running; i++) {
+        pthread_join(pool[i], NULL);
+    }
+
+    pthread_barrier_destroy(&bfs.barrier);
+    pthread_cond_destroy(&bfs.ready);
+    pthread_mutex_destroy(&bfs.lock);
+    for (int i = 0; i < threads; i++) {
+        free(bfs.buffers[i].cells);
+    }
+    free(bfs.buffers);
+    free(workers);
+    free(pool);
+    free(own);
+    scratch->explored = bfs.explored;
+
+    if (bfs.failed) {
+        printf("Error: Not enough memory to solve the maze.\n");
+        return false;
+    }
+    return BIT_TEST(bfs.visited, bfs.end);
+}
+
+bool expand_side_level(const Maze *maze, const long offset[4], SearchSide *side, const SearchSide *other,
+                       uint32_t *meet) {
+    /*
+     * Function for expanding one whole BFS level of one side of the bidirectional search
+     *  @param maze: pointer to the maze structure
+     *  @param offset: bit index offset of every direction
+     *  @param side: the side being expanded
+     *  @param other: the opposite side
+     *  @param meet: where to store the first cell found that the opposite side has already reached
+     * @return: true if the two sides met, false otherwise
+     * */
+    size_t level_end = side->tail;
+
+    while (side->head < level_end) {
+        uint32_t cell = SIDE_AT(side, side->head);
+        side->head++;
+
+        for (int i = 0; i < 4; i++) {
+            uint32_t next = (uint32_t) (cell + offset[i]);
+
+            if (!is_valid_move(maze, side->visited, next)) {
+                continue;
+            }
+
+            // ----- the first meeting is already a shortest path, both sides are one level deep at most from it -----
+            BIT_SET(side->visited, next);
+            dir_set(side->came_from, next, i);
+            if (BIT_TEST(other->visited, next)) {
+                *meet = next;
+                return true;
+            }
+
+            SIDE_AT(side, side->tail) = next;
+            side->tail++;
+        }
+    }
+
+    return false;
+}
+
+bool solve_maze_bidirectional(Maze *maze, SolverScratch *scratch) {
+    /*
+     * Function for solving the maze with two breadth-first searches, one from each end, meeting in the middle
+     *  @param maze: pointer to the maze structure
+     *  @param scratch: prepared scratch buffers, including the exit side ones
+     * @return: true if a solution is found (and marked), false otherwise
+     * */
+    long offset[4];
+    direction_offsets(maze, offset);
+    uint32_t start = MAZE_BIT(maze, maze->start_row, maze->start_col);
+    uint32_t end = MAZE_BIT(maze, maze->end_row, maze->end_col);
+
+    // ----- a cell is queued by one side only, so the two queues share the scratch queue from both ends -----
+    size_t cells = (size_t) maze->rows * maze->cols;
+    SearchSide from_start = {scratch->visited, scratch->came_from, scratch->queue, 1, 0, 0};
+    SearchSide from_end = {scratch->visited_exit, scratch->came_from_exit, scratch->queue + cells - 1, -1, 0, 0};
+
+    BIT_SET(from_start.visited, start);
+    SIDE_AT(&from_start, from_start.tail++) = start;
+    BIT_SET(from_end.visited, end);
+    SIDE_AT(&from_end, from_end.tail++) = end;
+
+    // ----- always growing the side with the smaller frontier -----
+    bool met = false;
+    uint32_t meet = 0;
+    while (!met && from_start.head < from_start.tail && from_end.head < from_end.tail) {
+        if (from_start.tail - from_start.head <= from_end.tail - from_end.head) {
+            met = expand_side_level(maze, offset, &from_start, &from_end, &meet);
+        } else {
+            met = expand_side_level(maze, offset, &from_end, &from_start, &meet);
+        }
+    }
+    scratch->explored = from_start.tail + from_end.tail;
+
+    // ----- both sides know how they reached the meeting cell: walking back to each end -----
+    if (met) {
+        mark_cell(maze, meet);
+        mark_chain(maze, from_start.came_from, meet, start);
+        mark_chain(maze, from_end.came_from, meet, end);
+    }
+    return met;
+}
+
+bool solve_maze_weighted(Maze *maze, SolverScratch *scratch) {
+    /*
+     * Function for solving a maze with terrain costs using Dijkstra's algorithm on a bucket queue
+     *  @param maze: pointer to the maze structure
+     *  @param scratch: prepared scratch buffers, including the weighted ones
+     * @return: true if a solution is found, false otherwise
+     * */
+    long offset[4];
+    direction_offsets(maze, offset);
+    uint32_t start = MAZE_BIT(maze, maze->start_row, maze->start_col);
+    uint32_t end = MAZE_BIT(maze, maze->end_row, maze->end_col);
+    uint32_t *dist = scratch->dist;
+    FrontierBuffer *buckets = scratch->buckets;
+
+    // ----- costs are kept in 32 bits, which no path through a smaller maze can exceed -----
+    if ((uint64_t) maze->rows * maze->cols * WEIGHT_MAX >= UINT32_MAX) {
+        printf("Error: The maze is too large for the weighted solver.\n");
+        return false;
+    }
+
+    // ----- every step costs 1 to WEIGHT_MAX, so the waiting cells always fit in WEIGHT_MAX + 1 buckets past the current cost -----
+    dist[start] = 0;
+    bool ok = frontier_push(&buckets[0], start);
+    size_t waiting = 1;
+    for (uint32_t cost = 0; ok && waiting > 0; cost++) {
+        FrontierBuffer *bucket = &buckets[cost % (WEIGHT_MAX + 1)];
+
+        // ----- cells reached from this bucket land in the others, so it can be walked in place -----
+        for (size_t k = 0; k < bucket->size && ok; k++) {
+            uint32_t cell = bucket->cells[k];
+
+            // ----- skipping stale entries of cells reached more cheaply since they were queued -----
+            if (dist[cell] != cost) {
+                continue;
+            }
+            BIT_SET(scratch->visited, cell);
+            scratch->explored++;
+
+            if (cell == end) {
+                return true;
+            }
+
+            for (int i = 0; i < 4 && ok; i++) {
+                uint32_t next = (uint32_t) (cell + offset[i]);
+
+                if (is_valid_move(maze, scratch->visited, next)) {
+                    uint32_t next_cost = cost + (maze->costs ? maze->costs[next] : 1);
+                    if (next_cost < dist[next]) {
+                        dist[next] = next_cost;
+                        dir_set(scratch->came_from, next, i);
+                        ok = frontier_push(&buckets[next_cost % (WEIGHT_MAX + 1)], next);
+                        waiting++;
+                    }
+                }
+            }
+        }
+        waiting -= bucket->size;
+        bucket->size = 0;
+    }
+
+    if (!ok) {
+        printf("Error: Not enough memory to solve the maze.\n");
+    }
+    return false;
+}
+
+uint32_t jump_horizontal(const Maze *maze, uint32_t cell, long step, uint32_t end) {
+    /*
+     * Function for running along a row until the path could have to turn
+     *  @param maze: pointer to the maze structure
+     *  @param cell: bit index of the cell to run from
+     *  @param step: +1 to run east, -1 to run west
+     *  @param end: bit index of the exit
+     * @return: bit index of the jump point reached, 0 (a border bit) if the run hits a wall first
+     * */
+    const uint64_t *walls = maze->walls;
+    long down = (long) maze->bit_stride;
+
+    for (;;) {
+        uint32_t next = (uint32_t) (cell + step);
+        if (BIT_TEST(walls, next)) {
+            return 0;
+        }
+        if (next == end) {
+            return next;
+        }
+
+        // ----- a forced neighbour: the cell above or below opens up right after a wall -----
+        if ((!BIT_TEST(walls, (uint32_t) (next - down)) && BIT_TEST(walls, (uint32_t) (cell - down))) ||
+            (!BIT_TEST(walls, (uint32_t) (next + down)) && BIT_TEST(walls, (uint32_t) (cell + down)))) {
+            return next;
+        }
+        cell = next;
+    }
+}
+
+uint32_t jump_vertical(const Maze *maze, uint32_t cell, long step, uint32_t end) {
+    /*
+     * Function for running along a column until a row crossing it leads somewhere
+     *  @param maze: pointer to the maze structure
+     *  @param cell: bit index of the cell to run from
+     *  @param step: bit_stride to run south, -bit_stride to run north
+     *  @param end: bit index of the exit
+     * @return: bit index of the jump point reached, 0 (a border bit) if the run hits a wall first
+     * */
+    for (;;) {
+        uint32_t next = (uint32_t) (cell + step);
+        if (BIT_TEST(maze->walls, next)) {
+            return 0;
+        }
+
+        // ----- paths turn from a column into a row anywhere, so every cell of the run scans its row both ways -----
+        if (next == end || jump_horizontal(maze, next, 1, end) || jump_horizontal(maze, next, -1, end)) {
+            return next;
+        }
+        cell = next;
+    }
+}
+
+void mark_jump_path(Maze *maze, const SolverScratch *scratch) {
+    /*
+     * Function for marking the path found by the jump point search, filling in the runs between jump points
+     *  @param maze: pointer to the maze structure
+     *  @param scratch: scratch buffers holding the cost and the entry direction of every expanded jump point
+     * */
+    long offset[4];
+    direction_offsets(maze, offset);
+    uint32_t start = MAZE_BIT(maze, maze->start_row, maze->start_col);
+    uint32_t cell = MAZE_BIT(maze, maze->end_row, maze->end_col);
+
+    // ----- a run ends at the first expanded cell whose cost fits: its parent, or a jump point just as cheap -----
+    while (cell != start) {
+        long step = offset[DIR_GET(scratch->came_from, cell)];
+        uint32_t cost = scratch->dist[cell];
+        do {
+            cell = (uint32_t) (cell - step);
+            cost--;
+            mark_cell(maze, cell);
+        } while (!BIT_TEST(scratch->visited, cell) || scratch->dist[cell] != cost);
+    }
+}
+
+bool solve_maze_jps(Maze *maze, SolverScratch *scratch) {
+    /*
+     * Function for solving the maze using A* over jump points, the only cells where a shortest path needs to turn
+     *  @param maze: pointer to the maze structure
+     *  @param scratch: prepared scratch buffers, with room for the cost of every cell
+     * @return: true if a solution is found, false otherwise
+     * */
+    long offset[4];
+    direction_offsets(maze, offset);
+    uint32_t start = MAZE_BIT(maze, maze->start_row, maze->start_col);
+    uint32_t end = MAZE_BIT(maze, maze->end_row, maze->end_col);
+    MinHeap *open = &scratch->open;
+
+    // ----- shortest paths can always be bent to turn into columns as early as possible, which is what the jumps rely on -----
+    uint32_t h = (uint32_t) (abs(maze->start_row - maze->end_row) + abs(maze->start_col - maze->end_col));
+    bool ok = heap_push(open, (HeapNode) {h, 0, start, 0});
+    while (ok && open->size > 0) {
+        HeapNode node = heap_pop(open);
+
+        if (BIT_TEST(scratch->visited, node.cell)) {
+            continue;
+        }
+        BIT_SET(scratch->visited, node.cell);
+        dir_set(scratch->came_from, node.cell, (int) node.dir);
+        scratch->dist[node.cell] = node.g;
+        scratch->explored++;
+
+        if (node.cell == end) {
+            mark_jump_path(maze, scratch);
+            return true;
+        }
+
+        // ----- jumping every way but back; cells passed over on the way are never queued -----
+        for (int i = 0; i < 4 && ok; i++) {
+            if (node.cell != start && i == ((int) node.dir + 2) % 4) {
+                continue;
+            }
+
+            uint32_t next = dc[i] ? jump_horizontal(maze, node.cell, offset[i], end)
+                                  : jump_vertical(maze, node.cell, offset[i], end);
+            if (next != 0 && !BIT_TEST(scratch->visited, next)) {
+                uint32_t length = (uint32_t) (labs((long) next - (long) node.cell) / labs(offset[i]));
+                int row = (int) (next / maze->bit_stride) - 1;
+                int col = (int) (next % maze->bit_stride) - 1;
+                h = (uint32_t) (abs(row - maze->end_row) + abs(col - maze->end_col));
+                ok = heap_push(open, (HeapNode) {node.g + length + h, node.g + length, next, (uint32_t) i});
+            }
+        }
+    }
+
+    if (!ok) {
+        printf("Error: Not enough memory to solve the maze.\n");
+    }
+    return false;
+}
+
+bool solve_maze(Maze *maze, SolverMode mode, int threads, SolverScratch *scratch) {
+    /*
+     * Function for solving the maze and marking the path with dots
+     *  @param maze: pointer to the maze structure
+     *  @param mode: solving strategy to use
+     *  @param threads: number of threads for SOLVER_PARALLEL
+     *  @param scratch: working memory, grown as needed and reusable across calls
+     * @return: true if a solution is found, false otherwise
+     * */
+    if (!scratch_prepare(scratch, maze)) {
+        printf("Error: Not enough memory to solve the maze.\n");
+        return false;
+    }
+
+    bool found;
+    if (mode == SOLVER_BACKTRACK) {
+        found = solve_maze_backtrack(maze, scratch);
+    } else if (mode == SOLVER_ASTAR) {
+        found = solve_maze_astar(maze, scratch);
+    } else if (mode == SOLVER_PARALLEL) {
+        found = solve_maze_parallel_bfs(maze, scratch, threads > 0 ? threads : 1);
+    } else if (mode == SOLVER_BIDIRECTIONAL) {
+        // ----- the path runs through two searches, so this solver marks it by itself -----
+        if (!scratch_prepare_exit(scratch, maze)) {
+            printf("Error: Not enough memory to solve the maze.\n");
+            return false;
+        }
+        return solve_maze_bidirectional(maze, scratch);
+    } else if (mode == SOLVER_WEIGHTED) {
+        if (!scratch_prepare_weighted(scratch, maze)) {
+            printf("Error: Not enough memory to solve the maze.\n");
+            return false;
+        }
+        found = solve_maze_weighted(maze, scratch);
+    } else if (mode == SOLVER_JPS) {
+        // ----- only the jump points know their parent run, so this solver marks the path by itself -----
+        if (!scratch_reserve_dist(scratch, maze)) {
+            printf("Error: Not enough memory to solve the maze.\n");
+            return false;
+        }
+        return solve_maze_jps(maze, scratch);
+    } else {
+        found = solve_maze_bfs(maze, scratch);
+    }
+
+    if (found) {
+        mark_path(maze, scratch);
+    }
+    return found;
+}
+
+bool parse_solver_mode(const char *name, SolverMode *mode) {
+    /*
+     * Function for converting a mode name given on the command line
+     *  @param name: one of solver_mode_names
+     *  @param mode: where to store the parsed mode
+     * @return: true if the name is known, false otherwise
+     * */
+    for (int i = 0; i < SOLVER_MODE_COUNT; i++) {
+        if (strcmp(name, solver_mode_names[i]) == 0) {
+            *mode = (SolverMode) i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// -----------------------
+// ----- PATH OUTPUT -----
+// -----------------------
+bool trace_marked_path(Maze *maze, SolverScratch *scratch) {
+    /*
+     * Function for recovering the marked path of a solved maze as a chain of directions
+     *  @param maze: pointer to the solved maze structure
+     *  @param scratch: working memory; on success came_from leads from the exit back to the start
+     * @return: true if the start and the exit are connected by marked cells, false otherwise
+     * */
+    size_t bits = ((size_t) maze->rows + 2) * maze->bit_stride;
+    uint64_t *marked = malloc(bits / 8);
+    if (marked == NULL || !scratch_prepare(scratch, maze)) {
+        printf("Error: Not enough memory to trace the path.\n");
+        free(marked);
+        return false;
+    }
+
+    // ----- everything but the marked cells, the start and the exit becomes a wall -----
+    memset(marked, 0xff, bits / 8);
+    for (int row = 0; row < maze->rows; row++) {
+        const char *cells = &MAZE_CELL(maze, row, 0);
+        uint32_t bit = MAZE_BIT(maze, row, 0);
+
+        for (int col = 0; col < maze->cols; col++, bit++) {
+            if (cells[col] == '.' || cells[col] == 'S' || cells[col] == 'E') {
+                marked[bit >> 6] &= ~((uint64_t) 1 << (bit & 63));
+            }
+        }
+    }
+
+    // ----- a BFS restricted to the marked cells follows the path, whatever mode marked it -----
+    uint64_t *walls = maze->walls;
+    maze->walls = marked;
+    bool found = solve_maze_bfs(maze, scratch);
+    maze->walls = walls;
+
+    free(marked);
+    return found;
+}
+
+bool write_path(const char *filename, Maze *maze, SolverScratch *scratch) {
+    /*
+     * Function to write only the path of a solved maze, as runs of moves in the same direction
+     *  @param filename: name of the output file
+     *  @param maze: pointer to the solved maze structure
+     *  @param scratch: working memory, grown as needed
+     * @return: true if successful, false otherwise
+     * */
+    if (!trace_marked_path(maze, scratch)) {
+        return false;
+    }
+
+    long offset[4];
+    direction_offsets(maze, offset);
+    uint32_t start = MAZE_BIT(maze, maze->start_row, maze->start_col);
+    uint32_t end = MAZE_BIT(maze, maze->end_row, maze->end_col);
+
+    // ----- walking back from the exit, so the runs come out last to first -----
+    uint32_t *runs = scratch->queue;
+    size_t count = 0;
+    for (uint32_t cell = end; cell != start;) {
+        uint32_t dir = DIR_GET(scratch->came_from, cell);
+        if (count > 0 && runs[count - 1] >> 30 == dir && (runs[count - 1] & PATH_RUN_MAX) < PATH_RUN_MAX) {
+            runs[count - 1]++;
+        } else {
+            runs[count++] = dir << 30 | 1;
+        }
+        cell = (uint32_t) (cell - offset[dir]);
+    }
+    for (size_t i = 0; i < count / 2; i++) {
+        uint32_t run = runs[i];
+        runs[i] = runs[count - 1 - i];
+        runs[count - 1 - i] = run;
+    }
+
+    FILE *file = fopen(filename, "wb");
+    if (file == NULL) {
+        printf("Error opening output file: %s\n", filename);
+        return false;
+    }
+
+    PathFileHeader header = {
+            .magic = PATH_MAGIC,
+            .rows = (uint32_t) maze->rows,
+            .cols = (uint32_t) maze->cols,
+            .start_row = (uint32_t) maze->start_row,
+            .start_col = (uint32_t) maze->start_col,
+            .run_count = (uint32_t) count
+    };
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(runs, sizeof(uint32_t), count, file) == count;
+    ok = fclose(file) == 0 && ok;
+    if (!ok) {
+        printf("Error writing output file: %s\n", filename);
+    }
+    return ok;
+}
+
+// --------------------------
+// ----- DISTANCE FIELD -----
+// --------------------------
+uint32_t field_rank(const Maze *maze, const DistanceField *field, uint32_t cell) {
+    /*
+     * Function for finding the position of an open cell in the distance field
+     *  @param maze: pointer to the maze structure
+     *  @param field: pointer to the distance field
+     *  @param cell: bit index of an open cell
+     * @return: number of open cells before it
+     * */
+    uint64_t below = ((uint64_t) 1 << (cell & 63)) - 1;
+    return field->rank[cell >> 6] + (uint32_t) __builtin_popcountll(~maze->walls[cell >> 6] & below);
+}
+
+void distance_field_free(DistanceField *field) {
+    /*
+     * Function for releasing a distance field
+     *  @param field: pointer to the distance field
+     * */
+    free(field->dist);
+    free(field->rank);
+    memset(field, 0, sizeof(DistanceField));
+}
+
+bool distance_field_index(const Maze *maze, DistanceField *field) {
+    /*
+     * Function for counting the open cells and allocating one distance per open cell
+     *  @param maze: pointer to the maze structure
+     *  @param field: pointer to the distance field to set up
+     * @return: true if successful, false if out of memory
+     * */
+    size_t words = ((size_t) maze->rows + 2) * maze->bit_stride / 64;
+    field->rank = malloc(words * sizeof(uint32_t));
+    if (field->rank == NULL) {
+        return false;
+    }
+
+    // ----- prefix counts of the open cells, so a cell finds its slot with one popcount -----
+    uint32_t open = 0;
+    for (size_t w = 0; w < words; w++) {
+        field->rank[w] = open;
+        open += (uint32_t) __builtin_popcountll(~maze->walls[w]);
+    }
+
+    field->open_cells = open;
+    field->dist = malloc(((size_t) open + 1) * sizeof(uint32_t));
+    return field->dist != NULL;
+}
+
+bool build_distance_field(const Maze *maze, DistanceField *field, SolverScratch *scratch) {
+    /*
+     * Function for computing the distance from every open cell to the exit with one reverse BFS
+     *  @param maze: pointer to the maze structure
+     *  @param field: pointer to the distance field to fill
+     *  @param scratch: working memory, grown as needed
+     * @return: true if successful, false if out of memory
+     * */
+    if (!scratch_prepare(scratch, maze) || !distance_field_index(maze, field)) {
+        printf("Error: Not enough memory to build the distance field.\n");
+        distance_field_free(field);
+        return false;
+    }
+    for (size_t i = 0; i < field->open_cells; i++) {
+        field->dist[i] = UINT32_MAX;
+    }
+
+    long offset[4];
+    direction_offsets(maze, offset);
+    uint32_t end = MAZE_BIT(maze, maze->end_row, maze->end_col);
+
+    // ----- breadth-first from the exit; the distance of a cell is one more than the one it was found from -----
+    uint32_t *queue = scratch->queue;
+    size_t head = 0, tail = 0;
+    queue[tail++] = end;
+    BIT_SET(scratch->visited, end);
+    field->dist[field_rank(maze, field, end)] = 0;
+
+    while (head < tail) {
+        uint32_t cell = queue[head++];
+        uint32_t next_dist = field->dist[field_rank(maze, field, cell)] + 1;
+
+        for (int i = 0; i < 4; i++) {
+            uint32_t next = (uint32_t) (cell + offset[i]);
+
+            if (is_valid_move(maze, scratch->visited, next)) {
+                BIT_SET(scratch->visited, next);
+                field->dist[field_rank(maze, field, next)] = next_dist;
+                queue[tail++] = next;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool query_distance_field(Maze *maze, const DistanceField *field, int row, int col) {
+    /*
+     * Function for marking the shortest path from any cell to the exit by walking down the distance field
+     *  @param maze: pointer to the maze structure
+     *  @param field: distance field built for this maze
+     *  @param row: row of the start cell
+     *  @param col: column of the start cell
+     * @return: true if the exit is reachable from the cell, false otherwise
+     * */
+    if (row < 0 || row >= maze->rows || col < 0 || col >= maze->cols) {
+        return false;
+    }
+    uint32_t cell = MAZE_BIT(maze, row, col);
+    if (BIT_TEST(maze->walls, cell)) {
+        return false;
+    }
+    uint32_t dist = field->dist[field_rank(maze, field, cell)];
+    if (dist == UINT32_MAX) {
+        return false;
+    }
+
+    long offset[4];
+    direction_offsets(maze, offset);
+
+    // ----- every step goes to a neighbour one closer to the exit, so no search is needed -----
+    while (dist > 0) {
+        mark_cell(maze, cell);
+        for (int i = 0; i < 4; i++) {
+            uint32_t next = (uint32_t) (cell + offset[i]);
+
+            if (!BIT_TEST(maze->walls, next) && field->dist[field_rank(maze, field, next)] == dist - 1) {
+                cell = next;
+                break;
+            }
+        }
+        dist--;
+    }
+
+    return true;
+}
+
+bool save_distance_field(const char *filename, const Maze *maze, const DistanceField *field) {
+    /*
+     * Function for saving a distance field next to its maze
+     *  @param filename: name of the output file
+     *  @param maze: maze the field was built for
+     *  @param field: pointer to the distance field
+     * @return: true if successful, false otherwise
+     * */
+    FILE *file = fopen(filename, "wb");
+    if (file == NULL) {
+        printf("Error opening output file: %s\n", filename);
+        return false;
+    }
+
+    DistanceFieldHeader header = {
+            .magic = DIST_MAGIC,
+            .rows = (uint32_t) maze->rows,
+            .cols = (uint32_t) maze->cols,
+            .end_row = (uint32_t) maze->end_row,
+            .end_col = (uint32_t) maze->end_col,
+            .open_cells = field->open_cells
+    };
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(field->dist, sizeof(uint32_t), field->open_cells, file) == field->open_cells;
+    ok = fclose(file) == 0 && ok;
+    if (!ok) {
+        printf("Error writing the distance field: %s\n", filename);
+    }
+    return ok;
+}
+
+bool load_distance_field(const char *filename, const Maze *maze, DistanceField *field) {
+    /*
+     * Function for loading a distance field saved for this maze
+     *  @param filename: name of the distance field file
+     *  @param maze: maze the field was built for
+     *  @param field: pointer to the distance field to fill
+     * @return: true if successful, false otherwise
+     * */
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL) {
+        printf("Error opening distance field file: %s\n", filename);
+        return false;
+    }
+
+    DistanceFieldHeader header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, DIST_MAGIC, 4) == 0 &&
+              header.rows == (uint32_t) maze->rows && header.cols == (uint32_t) maze->cols &&
+              header.end_row == (uint32_t) maze->end_row && header.end_col == (uint32_t) maze->end_col;
+
+    // ----- the slot of every cell is rebuilt from the walls, which must agree with the saved count -----
+    if (ok && !distance_field_index(maze, field)) {
+        printf("Error: Not enough memory to load the distance field.\n");
+        fclose(file);
+        distance_field_free(field);
+        return false;
+    }
+    ok = ok && header.open_cells == field->open_cells &&
+         fread(field->dist, sizeof(uint32_t), field->open_cells, file) == field->open_cells;
+
+    fclose(file);
+    if (!ok) {
+        printf("Error: %s is not a distance field for this maze.\n", filename);
+        distance_field_free(field);
+    }
+    return ok;
+}
+
+// ----------------------
+// ----- BATCH MODE -----
+// ----------------------
+bool batch_add_job(BatchQueue *queue, const char *input, const char *output) {
+    /*
+     * Function for appending an input/output pair to the batch
+     *  @param queue: pointer to the batch queue
+     *  @param input: path of the maze to solve
+     *  @param output: path to write the solved maze to
+     * @return: true if successful, false if out of memory
+     * */
+    if (queue->count == queue->capacity) {
+        size_t capacity = queue->capacity ? queue->capacity * 2 : 64;
+        BatchJob *jobs = realloc(queue->jobs, capacity * sizeof(BatchJob));
+        if (jobs == NULL) {
+            return false;
+        }
+        queue->jobs = jobs;
+        queue->capacity = capacity;
+    }
+
+    BatchJob *job = &queue->jobs[queue->count];
+    job->input = strdup(input);
+    job->output = strdup(output);
+    job->seconds = 0;
+    job->solved = false;
+    if (job->input == NULL || job->output == NULL) {
+        free(job->input);
+        free(job->output);
+        return false;
+    }
+
+    queue->count++;
+    return true;
+}
+
+void batch_free(BatchQueue *queue) {
+    /*
+     * Function for releasing the jobs of a batch and the paths they own
+     *  @param queue: pointer to the batch queue
+     * */
+    for (size_t i = 0; i < queue->count; i++) {
+        free(queue->jobs[i].input);
+        free(queue->jobs[i].output);
+    }
+    free(queue->jobs);
+    queue->jobs = NULL;
+    queue->count = queue->capacity = 0;
+}
+
+bool batch_load(BatchQueue *queue, const char *source) {
+    /*
+     * Function for collecting the jobs of a batch
+     *  @param queue: pointer to the batch queue
+     *  @param source: a directory (every *.dat is solved into *_solved.dat next to it)
+     *                 or a manifest file with one "input output" pair per line
+     * @return: true if successful, false otherwise
+     * */
+    DIR *dir = opendir(source);
+    if (dir != NULL) {
+        struct dirent *item;
+        bool ok = true;
+        while (ok && (item = readdir(dir)) != NULL) {
+            size_t length = strlen(item->d_name);
+            if (length < 4 || strcmp(item->d_name + length - 4, ".dat") != 0 ||
+                (length >= 11 && strcmp(item->d_name + length - 11, "_solved.dat") == 0)) {
+                continue;
+            }
+
+            // ----- building "<dir>/<name>.dat" and "<dir>/<name>_solved.dat" -----
+            size_t size = strlen(source) + length + 16;
+            char *input = malloc(size), *output = malloc(size);
+            ok = input != NULL && output != NULL;
+            if (ok) {
+                snprintf(input, size, "%s/%s", source, item->d_name);
+                snprintf(output, size, "%s/%.*s_solved.dat", source, (int) (length - 4), item->d_name);
+                ok = batch_add_job(queue, input, output);
+            }
+            free(input);
+            free(output);
+        }
+        closedir(dir);
+        if (!ok) {
+            printf("Error: Not enough memory to load the batch.\n");
+        }
+        return ok;
+    }
+
+    FILE *manifest = fopen(source, "r");
+    if (manifest == NULL) {
+        printf("Error opening batch manifest or directory: %s\n", source);
+        return false;
+    }
+
+    // ----- one "input output" pair per line, blank lines and '#' comments are skipped -----
+    char *line = NULL;
+    size_t line_capacity = 0;
+    bool ok = true;
+    for (int number = 1; ok && getline(&line, &line_capacity, manifest) >= 0; number++) {
+        char *input = strtok(line, " \t\r\n");
+        if (input == NULL || input[0] == '#') {
+            continue;
+        }
+        char *output = strtok(NULL, " \t\r\n");
+        if (output == NULL) {
+            printf("Error: Missing output path on line %d of %s\n", number, source);
+            ok = false;
+        } else if (!(ok = batch_add_job(queue, input, output))) {
+            printf("Error: Not enough memory to load the batch.\n");
+        }
+    }
+
+    free(line);
+    fclose(manifest);
+    return ok;
+}
+
+double elapsed_seconds(const struct timespec *since) {
+    /*
+     * Function for measuring the time passed since a given moment
+     *  @param since: moment taken with CLOCK_MONOTONIC
+     * @return: the elapsed time in seconds
+     * */
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) (now.tv_sec - since->tv_sec) + (double) (now.tv_nsec - since->tv_nsec) / 1e9;
+}
+
+void *batch_worker(void *arg) {
+    /*
+     * Function run by every thread of the pool: takes jobs until none are left
+     *  @param arg: pointer to the shared batch queue
+     * */
+    BatchQueue *queue = arg;
+
+    // ----- the scratch buffers only grow, so after the largest maze no more allocations happen -----
+    SolverScratch scratch = {0};
+
+    size_t index;
+    while ((index = atomic_fetch_add(&queue->next, 1)) < queue->count) {
+        BatchJob *job = &queue->jobs[index];
+        struct timespec started;
+        clock_gettime(CLOCK_MONOTONIC, &started);
+
+        Maze maze;
+        if (read_maze(job->input, &maze)) {
+            job->solved = solve_maze(&maze, queue->mode, 1, &scratch) && write_maze(job->output, &maze);
+            if (!job->solved) {
+                printf("No solution written for the maze: %s\n", job->input);
+            }
+            maze_free(&maze);
+        }
+
+        job->seconds = elapsed_seconds(&started);
+    }
+
+    scratch_free(&scratch);
+    return NULL;
+}
+
+int compare_doubles(const void *a, const void *b) {
+    /*
+     * Function for ordering doubles ascending with qsort
+     * */
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+bool run_batch(const char *source, SolverMode mode, int threads) {
+    /*
+     * Function for solving a batch of mazes on a fixed pool of worker threads
+     *  @param source: manifest file or directory, see batch_load
+     *  @param mode: solving strategy to use
+     *  @param threads: number of worker threads
+     * @return: true if every maze was solved, false otherwise
+     * */
+    BatchQueue queue = {0};
+    queue.mode = mode;
+    // ----- a load that failed partway already said why, and keeps the jobs it added until here -----
+    bool loaded = batch_load(&queue, source);
+    if (loaded && queue.count == 0) {
+        printf("Error: No mazes to solve in %s\n", source);
+    }
+    if (!loaded || queue.count == 0) {
+        batch_free(&queue);
+        return false;
+    }
+    if ((size_t) threads > queue.count) {
+        threads = (int) queue.count;
+    }
+
+    struct timespec started;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+
+    // ----- starting the pool; if a thread can't be created, the ones we have share the work -----
+    pthread_t *pool = malloc(threads * sizeof(pthread_t));
+    int running = 0;
+    while (pool != NULL && running < threads && pthread_create(&pool[running], NULL, batch_worker, &queue) == 0) {
+        running++;
+    }
+    if (running == 0) {
+        batch_worker(&queue);
+    }
+    for (int i = 0; i < running; i++) {
+        pthread_join(pool[i], NULL);
+    }
+    double total = elapsed_seconds(&started);
+    free(pool);
+
+    // ----- aggregating the results -----
+    size_t solved = 0;
+    double *latencies = malloc(queue.count * sizeof(double));
+    for (size_t i = 0; i < queue.count; i++) {
+        solved += queue.jobs[i].solved;
+        if (latencies != NULL) {
+            latencies[i] = queue.jobs[i].seconds * 1000;
+        }
+    }
+
+    printf("\nBatch Summary:\n");
+    printf("Mazes: %zu (%zu solved) on %d threads\n", queue.count, solved, running ? running : 1);
+    printf("Total time: %.3f s\n", total);
+    printf("Throughput: %.1f mazes/sec\n", (double) queue.count / total);
+    if (latencies != NULL) {
+        qsort(latencies, queue.count, sizeof(double), compare_doubles);
+        double percentiles[] = {50, 90, 99, 100};
+        for (int i = 0; i < 4; i++) {
+            size_t rank = (size_t) (percentiles[i] / 100 * (double) queue.count + 0.999999);
+            printf("Latency p%-3.0f %10.3f ms\n", percentiles[i], latencies[rank ? rank - 1 : 0]);
+        }
+    }
+
+    free(latencies);
+    bool all = solved == queue.count;
+    batch_free(&queue);
+    return all;
+}
+
+// ----------------------------------
+// ----- STREAMING REACHABILITY -----
+// ----------------------------------
+uint32_t reach_find(uint32_t *parent, uint32_t i) {
+    /*
+     * Function for finding the root of a cell's component, halving the path on the way
+     *  @param parent: parent of every cell of the band
+     *  @param i: index of an open cell in the band
+     * @return: index of the root
+     * */
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+void reach_union(ReachBands *bands, uint32_t a, uint32_t b) {
+    /*
+     * Function for merging the components of two adjacent open cells
+     *  @param bands: pointer to the band state
+     *  @param a: index of the first cell
+     *  @param b: index of the second cell
+     * */
+    a = reach_find(bands->parent, a);
+    b = reach_find(bands->parent, b);
+    if (a == b) {
+        return;
+    }
+
+    // ----- hanging the smaller component under the larger one keeps the trees shallow -----
+    Component *big = &bands->info[a], *small = &bands->info[b];
+    if (big->size < small->size) {
+        Component *swap = big;
+        big = small;
+        small = swap;
+        uint32_t root = a;
+        a = b;
+        b = root;
+    }
+    bands->parent[b] = a;
+    big->size += small->size;
+    big->start_seq = big->start_seq > small->start_seq ? big->start_seq : small->start_seq;
+    big->end_seq = big->end_seq > small->end_seq ? big->end_seq : small->end_seq;
+}
+
+void reach_close_band(ReachBands *bands, int filled, bool last) {
+    /*
+     * Function for settling the components that can't grow any more and moving the bottom row up as the boundary
+     *  @param bands: pointer to the band state
+     *  @param filled: rows of the band read so far (the bottom row is row filled)
+     *  @param last: true at the end of the maze, when every component is settled
+     * */
+    int cols = bands->cols;
+    uint32_t *parent = bands->parent;
+    uint32_t *bottom = parent + (size_t) filled * cols;
+    uint32_t base = (uint32_t) ((size_t) filled * cols);
+
+    // ----- components reaching the bottom row live on, numbered by their first column there -----
+    for (int col = 0; !last && col < cols; col++) {
+        if (bottom[col] != REACH_WALL) {
+            uint32_t root = reach_find(parent, base + col);
+            if (bands->label[root] == REACH_WALL) {
+                bands->label[root] = (uint32_t) col;
+                bands->next_info[col] = bands->info[root];
+            }
+        }
+    }
+
+    // ----- any other component is complete; only the one holding the latest 'S' matters -----
+    size_t cells = ((size_t) filled + 1) * cols;
+    for (uint32_t i = 0; i < cells; i++) {
+        if (parent[i] == i && bands->label[i] == REACH_WALL && bands->info[i].start_seq > bands->start.start_seq) {
+            bands->start = bands->info[i];
+        }
+    }
+    if (last) {
+        return;
+    }
+
+    // ----- relabelling the bottom row, then clearing the labels for the next band -----
+    for (int col = 0; col < cols; col++) {
+        bands->next_parent[col] = bottom[col] == REACH_WALL ? REACH_WALL
+                                                             : bands->label[reach_find(parent, base + col)];
+    }
+    for (int col = 0; col < cols; col++) {
+        if (bottom[col] != REACH_WALL) {
+            bands->label[reach_find(parent, base + col)] = REACH_WALL;
+        }
+    }
+    memcpy(parent, bands->next_parent, cols * sizeof(uint32_t));
+    for (int col = 0; col < cols; col++) {
+        if (parent[col] == (uint32_t) col) {
+            bands->info[col] = bands->next_info[col];
+        }
+    }
+}
+
+bool stream_reachability(const char *filename, int band_rows) {
+    /*
+     * Function for checking whether the exit can be reached without holding the maze in memory
+     *  @param filename: name of the input file, "-" for stdin
+     *  @param band_rows: rows kept in memory at once, 0 to pick about REACH_BAND_CELLS cells
+     * @return: true if the exit can be reached from the start, false otherwise
+     * */
+    FILE *file = strcmp(filename, "-") == 0 ? stdin : fopen(filename, "r");
+    if (file == NULL) {
+        printf("Error opening input file: %s\n", filename);
+        return false;
+    }
+
+    // ----- the first line gives the column count, as in read_maze_stream -----
+    char *line = NULL;
+    size_t line_capacity = 0;
+    ssize_t length = getline(&line, &line_capacity, file);
+    while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+        length--;
+    }
+    if (length <= 0) {
+        printf("Error: The maze file is empty: %s\n", filename);
+        free(line);
+        if (file != stdin) {
+            fclose(file);
+        }
+        return false;
+    }
+
+    ReachBands bands = {0};
+    bands.cols = (int) length;
+    bands.rows = band_rows > 0 ? band_rows : (int) (REACH_BAND_CELLS / length + 1);
+    size_t cells = ((size_t) bands.rows + 1) * bands.cols;
+    bool ok = cells < REACH_WALL;
+    if (ok) {
+        bands.parent = malloc(cells * sizeof(uint32_t));
+        bands.info = malloc(cells * sizeof(Component));
+        bands.label = malloc(cells * sizeof(uint32_t));
+        bands.next_parent = malloc(bands.cols * sizeof(uint32_t));
+        bands.next_info = malloc(bands.cols * sizeof(Component));
+        ok = bands.parent && bands.info && bands.label && bands.next_parent && bands.next_info;
+    }
+    if (ok) {
+        memset(bands.label, 0xff, cells * sizeof(uint32_t));
+        memset(bands.parent, 0xff, bands.cols * sizeof(uint32_t));
+    } else {
+        printf("Error: Not enough memory for a band of %d rows.\n", bands.rows);
+    }
+
+    // ----- every row is joined to its left neighbours and to the row above, which may be the boundary row -----
+    uint64_t rows = 0, starts = 0, ends = 0;
+    int filled = 0;
+    while (ok && length >= 0) {
+        if (filled == bands.rows) {
+            reach_close_band(&bands, filled, false);
+            filled = 0;
+        }
+        filled++;
+
+        uint32_t base = (uint32_t) ((size_t) filled * bands.cols);
+        bool more = true;
+        for (int col = 0; col < bands.cols; col++) {
+            // ----- short rows are padded with walls, as read_maze_stream does -----
+            more = more && col < length && line[col] != '\n' && line[col] != '\r';
+            uint32_t i = base + col;
+            if (!more || line[col] == '#') {
+                bands.parent[i] = REACH_WALL;
+                continue;
+            }
+
+            bands.parent[i] = i;
+            bands.info[i] = (Component) {1, line[col] == 'S' ? ++starts : 0, line[col] == 'E' ? ++ends : 0};
+            if (col > 0 && bands.parent[i - 1] != REACH_WALL) {
+                reach_union(&bands, i - 1, i);
+            }
+            if (bands.parent[i - bands.cols] != REACH_WALL) {
+                reach_union(&bands, i - bands.cols, i);
+            }
+        }
+
+        rows++;
+        length = getline(&line, &line_capacity, file);
+    }
+    if (ok) {
+        reach_close_band(&bands, filled, true);
+    }
+
+    free(line);
+    free(bands.parent);
+    free(bands.info);
+    free(bands.label);
+    free(bands.next_parent);
+    free(bands.next_info);
+    if (file != stdin) {
+        fclose(file);
+    }
+    if (!ok) {
+        return false;
+    }
+
+    // ----- like read_maze, the last 'S' and 'E' count -----
+    if (starts == 0 || ends == 0) {
+        printf("Error: Could not find start 'S' or end 'E' in the maze.\n");
+        return false;
+    }
+    bool reachable = bands.start.end_seq == ends;
+    printf("Rows: %llu, columns: %d, band: %d rows\n", (unsigned long long) rows, bands.cols, bands.rows);
+    printf("Exit reachable: %s\n", reachable ? "yes" : "no");
+    printf("Cells connected to the start: %llu\n", (unsigned long long) bands.start.size);
+    return reachable;
+}
+
+// ---------------------
+// ----- BENCHMARK -----
+// ---------------------
+uint64_t next_random(uint64_t *state) {
+    /*
+     * Function for drawing the next number of a splitmix64 sequence, so mazes are reproducible from a seed
+     *  @param state: generator state, advanced in place
+     * @return: a pseudo-random 64-bit number
+     * */
+    uint64_t z = (*state += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+void carve_perfect_maze(Maze *maze, uint64_t *seed) {
+    /*
+     * Function for carving a perfect maze (exactly one path between any two cells) with a randomized DFS
+     *  @param maze: maze whose grid is all walls; the cells with odd coordinates become the corridors
+     *  @param seed: generator state
+     * */
+
+    // ----- a carved cell stores the direction back to its parent ('4' for the root), so no stack is needed -----
+    int last_row = (maze->rows - 2) | 1, last_col = (maze->cols - 2) | 1;
+    if (last_row > maze->rows - 2) {
+        last_row -= 2;
+    }
+    if (last_col > maze->cols - 2) {
+        last_col -= 2;
+    }
+    int row = 1, col = 1;
+    MAZE_CELL(maze, row, col) = '4';
+
+    while (true) {
+        int options[4], count = 0;
+        for (int i = 0; i < 4; i++) {
+            int r = row + 2 * dr[i], c = col + 2 * dc[i];
+            if (r >= 1 && r <= last_row && c >= 1 && c <= last_col && MAZE_CELL(maze, r, c) == '#') {
+                options[count++] = i;
+            }
+        }
+
+        if (count > 0) {
+            int i = options[next_random(seed) % count];
+            MAZE_CELL(maze, row + dr[i], col + dc[i]) = ' ';
+            row += 2 * dr[i];
+            col += 2 * dc[i];
+            MAZE_CELL(maze, row, col) = (char) ('0' + (i + 2) % 4);
+        } else {
+            // ----- dead end: backtracking towards the root -----
+            int back = MAZE_CELL(maze, row, col) - '0';
+            MAZE_CELL(maze, row, col) = ' ';
+            if (back == 4) {
+                break;
+            }
+            row += 2 * dr[back];
+            col += 2 * dc[back];
+        }
+    }
+
+    maze->start_row = maze->start_col = 1;
+    maze->end_row = last_row;
+    maze->end_col = last_col;
+}
+
+void carve_rooms(Maze *maze, uint64_t *seed) {
+    /*
+     * Function for dividing an open floor into square rooms joined by one door per wall segment
+     *  @param maze: maze whose grid is all walls
+     *  @param seed: generator state
+     * */
+    for (int row = 0; row < maze->rows; row++) {
+        for (int col = 0; col < maze->cols; col++) {
+            MAZE_CELL(maze, row, col) = row % BENCH_ROOM_SIZE == BENCH_ROOM_SIZE - 1 ||
+                                        col % BENCH_ROOM_SIZE == BENCH_ROOM_SIZE - 1 ? '#' : ' ';
+        }
+    }
+
+    // ----- a door somewhere along every wall segment between two rooms -----
+    for (int top = 0; top < maze->rows; top += BENCH_ROOM_SIZE) {
+        for (int left = 0; left < maze->cols; left += BENCH_ROOM_SIZE) {
+            // ----- rooms on the last row or column may be cut short by the edge of the grid -----
+            int width = maze->cols - left < BENCH_ROOM_SIZE - 1 ? maze->cols - left : BENCH_ROOM_SIZE - 1;
+            int height = maze->rows - top < BENCH_ROOM_SIZE - 1 ? maze->rows - top : BENCH_ROOM_SIZE - 1;
+            int wall_row = top + BENCH_ROOM_SIZE - 1, wall_col = left + BENCH_ROOM_SIZE - 1;
+
+            int door = (int) (next_random(seed) % width);
+            if (wall_row < maze->rows) {
+                MAZE_CELL(maze, wall_row, left + door) = ' ';
+            }
+            door = (int) (next_random(seed) % height);
+            if (wall_col < maze->cols) {
+                MAZE_CELL(maze, top + door, wall_col) = ' ';
+            }
+        }
+    }
+
+    maze->start_row = maze->start_col = 0;
+    maze->end_row = maze->rows - 1 - (maze->rows % BENCH_ROOM_SIZE == 0);
+    maze->end_col = maze->cols - 1 - (maze->cols % BENCH_ROOM_SIZE == 0);
+}
+
+void carve_spiral(Maze *maze) {
+    /*
+     * Function for carving one corridor that spirals from the corner to the middle, so the path covers half the grid
+     *  @param maze: maze whose grid is all walls
+     * */
+    int row = 1, col = 1, dir = 1;
+    MAZE_CELL(maze, row, col) = ' ';
+
+    // ----- going straight two cells at a time, turning right when the way ahead is carved or outside -----
+    for (int turns = 0; turns < 2;) {
+        int r = row + 2 * dr[dir], c = col + 2 * dc[dir];
+        if (r >= 1 && r <= maze->rows - 2 && c >= 1 && c <= maze->cols - 2 && MAZE_CELL(maze, r, c) == '#') {
+            MAZE_CELL(maze, row + dr[dir], col + dc[dir]) = ' ';
+            MAZE_CELL(maze, r, c) = ' ';
+            row = r;
+            col = c;
+            turns = 0;
+        } else {
+            dir = (dir + 1) % 4;
+            turns++;
+        }
+    }
+
+    maze->start_row = maze->start_col = 1;
+    maze->end_row = row;
+    maze->end_col = col;
+}
+
+bool generate_maze(Maze *maze, BenchKind kind, int size, uint64_t seed) {
+    /*
+     * Function for generating a reproducible size x size maze in memory
+     *  @param maze: pointer to the maze structure to fill
+     *  @param kind: layout to generate
+     *  @param size: number of rows and columns (at least 5)
+     *  @param seed: seed of the generator
+     * @return: true if successful, false if out of memory
+     * */
+    memset(maze, 0, sizeof(Maze));
+    maze->rows = maze->cols = size;
+    maze->stride = (size_t) size + 1;
+    maze->grid = malloc((size_t) size * maze->stride);
+    if (maze->grid == NULL) {
+        return false;
+    }
+    for (int row = 0; row < size; row++) {
+        memset(&MAZE_CELL(maze, row, 0), '#', size);
+        MAZE_CELL(maze, row, size) = '\n';
+    }
+
+    if (kind == BENCH_ROOMS) {
+        carve_rooms(maze, &seed);
+    } else if (kind == BENCH_SPIRAL) {
+        carve_spiral(maze);
+    } else {
+        carve_perfect_maze(maze, &seed);
+    }
+
+    // ----- an unsolvable maze is a perfect one with the exit walled in -----
+    if (kind == BENCH_UNSOLVABLE) {
+        for (int i = 0; i < 4; i++) {
+            MAZE_CELL(maze, maze->end_row + dr[i], maze->end_col + dc[i]) = '#';
+        }
+    }
+    MAZE_CELL(maze, maze->start_row, maze->start_col) = 'S';
+    MAZE_CELL(maze, maze->end_row, maze->end_col) = 'E';
+
+    if (!build_wall_bitmap(maze)) {
+        maze_free(maze);
+        return false;
+    }
+    return true;
+}
+
+long peak_rss_mb(void) {
+    /*
+     * Function for reading the peak resident memory of the process so far
+     * @return: the peak resident set size in MB
+     * */
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024;
+}
+
+bool bench_step(const BenchCase *bench, int step) {
+    /*
+     * Function for timing one step of the benchmark and printing its row; it runs in a process of its own, so the
+     * peak memory of the row belongs to this step alone (plus loading the maze, which a solver run needs as well)
+     *  @param bench: the maze to benchmark
+     *  @param step: BENCH_STEP_WRITE generates the maze and writes it to bench->path, BENCH_STEP_READ reads it
+     *               back, any other value solves it with that SolverMode
+     * @return: true if the step ran, false otherwise
+     * */
+    const char *kinds[] = {"perfect", "rooms", "spiral", "unsolvable"};
+    double cells = (double) bench->size * bench->size;
+    struct timespec started;
+    double seconds;
+    Maze maze;
+
+    // ----- generating, then writing the maze out for the steps that read it back through the real loader -----
+    if (step == BENCH_STEP_WRITE) {
+        if (!generate_maze(&maze, bench->kind, bench->size, bench->seed)) {
+            printf("Error: Not enough memory to generate a %d x %d maze.\n", bench->size, bench->size);
+            return false;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &started);
+        bool ok = write_maze(bench->path, &maze);
+        seconds = elapsed_seconds(&started);
+        maze_free(&maze);
+        printf("%-10s %6d %-13s %10.4f %12.1f %12s %6s %9ld\n",
+               kinds[bench->kind], bench->size, "write_maze", seconds, cells / seconds / 1e6, "-", "-", peak_rss_mb());
+        return ok;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &started);
+    if (!read_maze(bench->path, &maze)) {
+        return false;
+    }
+    seconds = elapsed_seconds(&started);
+    if (step == BENCH_STEP_READ) {
+        printf("%-10s %6d %-13s %10.4f %12.1f %12s %6s %9ld\n",
+               kinds[bench->kind], bench->size, "read_maze", seconds, cells / seconds / 1e6, "-", "-", peak_rss_mb());
+        maze_free(&maze);
+        return true;
+    }
+
+    // ----- the scratch starts empty, so the mode pays for its own working memory like a single run does -----
+    SolverScratch scratch = {0};
+    clock_gettime(CLOCK_MONOTONIC, &started);
+    bool found = solve_maze(&maze, step, bench->threads, &scratch);
+    seconds = elapsed_seconds(&started);
+    printf("%-10s %6d %-13s %10.4f %12.1f %12zu %6s %9ld\n",
+           kinds[bench->kind], bench->size, solver_mode_names[step], seconds, cells / seconds / 1e6,
+           scratch.explored, found ? "yes" : "no", peak_rss_mb());
+
+    scratch_free(&scratch);
+    maze_free(&maze);
+    return true;
+}
+
+bool fork_bench_step(const BenchCase *bench, int step) {
+    /*
+     * Function for running bench_step in a child process and waiting for it; ru_maxrss only ever grows, so a
+     * fresh process per step is what keeps the peak memory of one row from hiding the next
+     *  @param bench: the maze to benchmark
+     *  @param step: the step, see bench_step
+     * @return: true if the step ran, false otherwise
+     * */
+    // ----- anything still buffered would be printed twice, once by each process -----
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        printf("Error starting a benchmark process.\n");
+        return false;
+    }
+    if (pid == 0) {
+        bool ok = bench_step(bench, step);
+        fflush(stdout);
+        _exit(ok ? 0 : 1);
+    }
+
+    int status;
+    if (waitpid(pid, &status, 0) != pid) {
+        return false;
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+bool run_benchmark(int max_size, uint64_t seed, int threads) {
+    /*
+     * Function for timing read_maze, write_maze and every solver mode on generated mazes of growing size
+     *  @param max_size: largest number of rows and columns to try
+     *  @param seed: seed of the maze generator
+     *  @param threads: number of threads for the parallel mode
+     * @return: true if every benchmark ran, false otherwise
+     * */
+    const int sizes[] = {100, 316, 1000, 3162, 10000};
+
+    printf("%-10s %6s %-13s %10s %12s %12s %6s %9s\n",
+           "maze", "size", "step", "time (s)", "Mcells/s", "explored", "found", "peak MB");
+
+    for (int kind = 0; kind < BENCH_KIND_COUNT; kind++) {
+        for (int s = 0; s < (int) (sizeof(sizes) / sizeof(sizes[0])) && sizes[s] <= max_size; s++) {
+            char path[] = "/tmp/maze_bench_XXXXXX";
+            int fd = mkstemp(path);
+            if (fd < 0) {
+                printf("Error creating a temporary file for the benchmark.\n");
+                return false;
+            }
+            close(fd);
+
+            // ----- every step runs in a process of its own; this one never holds a maze -----
+            BenchCase bench = {kind, sizes[s], seed, threads, path};
+            bool ok = true;
+            for (int step = BENCH_STEP_WRITE; ok && step < SOLVER_MODE_COUNT; step++) {
+                ok = fork_bench_step(&bench, step);
+            }
+            unlink(path);
+            if (!ok) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+
+    // ----- batch usage: --batch <manifest or directory> [mode] [threads]; every maze gets one thread -----
+    if (argc > 2 && strcmp(argv[1], "--batch") == 0) {
+        SolverMode mode = SOLVER_BFS;
+        if (argc > 3 && !parse_solver_mode(argv[3], &mode)) {
+            printf("Unknown solver mode: %s (expected backtrack, bfs, astar, parallel, bidirectional, weighted or jps)\n", argv[3]);
+            return 1;
+        }
+        int threads = argc > 4 ? atoi(argv[4]) : (int) sysconf(_SC_NPROCESSORS_ONLN);
+        return run_batch(argv[2], mode, threads > 0 ? threads : 1) ? 0 : 1;
+    }
+
+    // ----- benchmark usage: --bench [max size] [seed] [threads] -----
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        int max_size = argc > 2 ? atoi(argv[2]) : 10000;
+        uint64_t seed = argc > 3 ? strtoull(argv[3], NULL, 10) : 1;
+        int threads = argc > 4 ? atoi(argv[4]) : (int) sysconf(_SC_NPROCESSORS_ONLN);
+        return run_benchmark(max_size, seed, threads > 0 ? threads : 1) ? 0 : 1;
+    }
+
+    // ----- streaming usage: --reach <input file or -> [band rows], only answers whether the exit can be reached -----
+    if (argc > 2 && strcmp(argv[1], "--reach") == 0) {
+        return stream_reachability(argv[2], argc > 3 ? atoi(argv[3]) : 0) ? 0 : 1;
+    }
+
+    // ----- distance field usage: --distance <maze> <field file> -----
+    if (argc > 3 && strcmp(argv[1], "--distance") == 0) {
+        Maze maze;
+        if (!read_maze(argv[2], &maze)) {
+            return 1;
+        }
+        SolverScratch scratch = {0};
+        DistanceField field = {0};
+        bool ok = build_distance_field(&maze, &field, &scratch) && save_distance_field(argv[3], &maze, &field);
+        scratch_free(&scratch);
+        distance_field_free(&field);
+        maze_free(&maze);
+        return ok ? 0 : 1;
+    }
+
+    // ----- query usage: --query <maze> <field file> <output file> <row> <col> [<row> <col> ...] -----
+    if (argc > 6 && strcmp(argv[1], "--query") == 0) {
+        Maze maze;
+        if (!read_maze(argv[2], &maze)) {
+            return 1;
+        }
+        DistanceField field = {0};
+        bool ok = load_distance_field(argv[3], &maze, &field);
+        for (int i = 5; ok && i + 1 < argc; i += 2) {
+            if (!query_distance_field(&maze, &field, atoi(argv[i]), atoi(argv[i + 1]))) {
+                printf("The exit can't be reached from (%s, %s).\n", argv[i], argv[i + 1]);
+            }
+        }
+        ok = ok && write_maze(argv[4], &maze);
+        distance_field_free(&field);
+        maze_free(&maze);
+        return ok ? 0 : 1;
+    }
+
+    // ----- path usage: --path <input file> <output file> [mode] [threads], writes only the run-length encoded path -----
+    bool path_only = argc > 2 && strcmp(argv[1], "--path") == 0;
+    if (path_only) {
+        argv++;
+        argc--;
+    }
+
+    // ----- usage: [input file or - for stdin] [output file] [backtrack|bfs|astar|parallel|bidirectional|weighted|jps] [threads] -----
+    char *input_file = argc > 1 ? argv[1] : "inputData/small_maze.dat";
+    char *output_file = argc > 2 ? argv[2] : "output_maze.dat";
+    SolverMode mode = SOLVER_BFS;
+    if (argc > 3 && !parse_solver_mode(argv[3], &mode)) {
+        printf("Unknown solver mode: %s (expected backtrack, bfs, astar, parallel, bidirectional, weighted or jps)\n", argv[3]);
+        return 1;
+    }
+
+    // ----- reading the maze from input file -----
+    Maze maze;
+    if (!read_maze(input_file, &maze)) {
+        return 1;
+    }
+
+    // ----- solving the maze with the selected strategy -----
+    SolverScratch scratch = {0};
+    int threads = argc > 4 ? atoi(argv[4]) : (int) sysconf(_SC_NPROCESSORS_ONLN);
+    bool solved = solve_maze(&maze, mode, threads, &scratch);
+    printf("Explored cells: %zu\n", scratch.explored);
+    if (!solved) {
+        printf("No solution found for the maze.\n");
+        scratch_free(&scratch);
+        maze_free(&maze);
+        return 1;
+    }
+
+    // ----- writing the solution to an output file -----
+    bool written = path_only ? write_path(output_file, &maze, &scratch) : write_maze(output_file, &maze);
+    scratch_free(&scratch);
+    maze_free(&maze);
+    if (!written) {
+        return 1;
+    }
+
+    printf("Maze solved successfully!\n");
+    return 0;
+}